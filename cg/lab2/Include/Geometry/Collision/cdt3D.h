@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include "Common/m_ptr.h"
 #include "Geometry/primitives/range.h"
 #include "Geometry/Grid2L.h"
@@ -22,7 +23,10 @@ Collision3D:
 2.2     
 
   Column'e   
-           
+  //   (addFace, removeFace, updateFace 
+ - addFaces, removeFaces, updateFaces);      
+   ,       , - FrozenCollision3D (cdt3d_frozen.h)
+       - HeightPyramid (height_pyramid.h)
 
  Collision3D  :
 -    
@@ -294,6 +298,50 @@ namespace cg
          triangle_3          const face_;    
       };
 
+      //    ,    
+      struct ColumnCleaner
+         : grid2l_visitor_base<Grid_, ColumnCleaner>
+      {
+         ColumnCleaner(face_id faceid, std::vector<Index2L> & dirty)
+            :   face_id_ (faceid)
+            ,   dirty_   (dirty)
+         {}
+
+         template <class State>
+            bool operator () (State const &state, m_ptr<Column<Traits> > & column)
+         {
+            if (!column)
+               return false;
+
+#ifdef _OPENMP
+            omp_set_lock( &column->lock );
+#endif
+
+            typename Column<Traits>::Faces & faces = column->faces();
+            size_t const size = faces.size();
+
+            faces.erase(std::remove(faces.begin(), faces.end(), face_id_), faces.end());
+            bool const removed = faces.size() != size;
+
+#ifdef _OPENMP
+            omp_unset_lock( &column->lock );
+#endif
+
+            // zrange     refreshZRanges
+            if (removed)
+#ifdef _OPENMP
+#pragma omp critical (dirty_columns)
+#endif
+               dirty_.push_back(Index2L(state.big, state.small));
+
+            return false;
+         }
+
+      private:
+         face_id              const face_id_;
+         std::vector<Index2L>     & dirty_;
+      };
+
       struct subdivfunc {
          int operator () (int n) const {
             return traits_.subdivision(n);
@@ -337,6 +385,148 @@ namespace cg
          grid_.MakeSubdivision(subdiv);
 
          //    
+         insert_faces(p, q);
+      }
+
+      //  , big cell'     
+      Collision3D(Traits const & traits)
+         :   traits_ (traits)
+         ,   grid_   (traits_.transform(), traits_.extents())
+      {}
+
+      //   .     ,
+      //     ,  big cell'   .
+      //       old.
+      //   zrange     ( - )
+      //  refreshZRanges;     .
+      //    traits triangle_3 getTriangle(face_id).
+      template <class Iterator>
+         void addFace(Iterator t)
+      {
+         insert_face(t);
+      }
+
+      void removeFace(face_id id, triangle_3 const & old)
+      {
+         erase_face(id, old);
+      }
+
+      // t     
+      template <class Iterator>
+         void updateFace(Iterator t, triangle_3 const & old)
+      {
+         erase_face(traits_.getFaceId(t), old);
+         insert_face(t);
+      }
+
+      template <class Iterator>
+         void addFaces(Iterator p, Iterator q)
+      {
+         insert_faces(p, q);
+      }
+
+      void removeFaces(face_id const * ids, triangle_3 const * old, size_t count)
+      {
+         erase_faces(ids, old, count);
+         refreshZRanges();
+      }
+
+      // old[i] -   i-   [p, q)
+      template <class Iterator>
+         void updateFaces(Iterator p, Iterator q, triangle_3 const * old)
+      {
+         std::vector<face_id> ids;
+         for (Iterator t = p; t != q; ++t)
+            ids.push_back(traits_.getFaceId(t));
+
+         erase_faces(ids.empty() ? NULL : &ids[0], old, ids.size());
+         insert_faces(p, q);
+         refreshZRanges();
+      }
+
+      //  zrange ,    
+      void refreshZRanges()
+      {
+         std::sort(dirty_.begin(), dirty_.end());
+         dirty_.erase(std::unique(dirty_.begin(), dirty_.end()), dirty_.end());
+
+         int const n = (int)dirty_.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+         for (int i = 0; i < n; ++i)
+            refresh_zrange(dirty_[i]);
+
+         dirty_.clear();
+      }
+
+      Grid_ const & grid() const { return grid_; }
+      Grid_       & grid()       { return grid_; }
+
+      Traits const & traits() const { return traits_; }
+
+      typedef Grid_ grid_type;
+
+   private:
+      template <class Iterator>
+         void insert_face(Iterator t)
+      {
+         subdivide_missing(t);
+         visit_face(t);
+      }
+
+      // big cell',     ,  ,    ;
+      //         
+      template <class Iterator>
+         void subdivide_missing(Iterator t)
+      {
+         rectangle_2 bb;
+         if ( traits_.is_vertical_triangle( t ) )
+         {
+            segment_2 const s = traits_.getSegment2(t);
+            point_2 const pts[] = { s.P0(), s.P1() };
+            bb = rectangle_2::bounding(pts, pts + 2);
+         }
+         else
+         {
+            triangle_2 const tr = traits_.getTriangle2(t);
+            point_2 const pts[] = { tr[0], tr[1], tr[2] };
+            bb = rectangle_2::bounding(pts, pts + 3);
+         }
+         bb.inflate( epsilon<double>( ) );
+
+         point_2i const ext = grid_.extents();
+         point_2i const lo  = floor(grid_.world2local(bb.lo()));
+         point_2i const hi  = floor(grid_.world2local(bb.XY()));
+         int      const div = (std::max)(traits_.subdivision(1), 1);
+
+         for (int y = (std::max)(lo.y, 0); y <= (std::min)(hi.y, ext.y - 1); ++y)
+            for (int x = (std::max)(lo.x, 0); x <= (std::min)(hi.x, ext.x - 1); ++x)
+               grid_.Subdivide(point_2i(x, y), point_2i(div, div));
+      }
+
+      template <class Iterator>
+         void visit_face(Iterator t)
+      {
+         if ( traits_.is_vertical_triangle( t ) )
+         {
+            VColumnCreator creator( traits_.getFaceId(t), traits_.getTriangle(t) );
+            visit(grid_, traits_.getSegment2(t), creator);
+         }
+         else
+         {
+            ColumnCreator creator (grid_, traits_.getFaceId(t), traits_.getTriangle(t));
+            visit(grid_, traits_.getTriangle2(t), creator);
+         }
+      }
+
+      template <class Iterator>
+         void insert_faces(Iterator p, Iterator q)
+      {
+         //   ,       
+         for (Iterator t = p; t != q; ++t)
+            subdivide_missing(t);
+
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -345,33 +535,67 @@ namespace cg
 #ifdef _OPENMP
 #pragma omp single nowait
 #endif
-            {
-               if ( traits_.is_vertical_triangle( t ) )
-               {
-                  VColumnCreator creator( traits_.getFaceId(t), traits_.getTriangle(t) );
-                  visit(grid_, traits_.getSegment2(t), creator);
-               }
-               else
-               {
-                  ColumnCreator creator (grid_, traits_.getFaceId(t), traits_.getTriangle(t));
-                  visit(grid_, traits_.getTriangle2(t), creator);
-               }
-            }
+            visit_face(t);
          }
       }
 
-      Collision3D(Traits const & traits) : traits_(traits) {}
+      void erase_face(face_id id, triangle_3 const & old)
+      {
+         point_2 const pts[] = { point_2(old[0]), point_2(old[1]), point_2(old[2]) };
 
-      Grid_ const & grid() const { return grid_; }
-      Grid_       & grid()       { return grid_; }
+         rectangle_2 bb = rectangle_2::bounding(pts, pts + 3);
+         bb.inflate( epsilon<double>( ) );
 
-      Traits const & traits() const { return traits_; }
+         ColumnCleaner cleaner(id, dirty_);
+         visit(grid_, bb, cleaner);
+      }
 
-      typedef Grid_ grid_type;
+      void erase_faces(face_id const * ids, triangle_3 const * old, size_t count)
+      {
+         int const n = (int)count;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+         for (int i = 0; i < n; ++i)
+            erase_face(ids[i], old[i]);
+      }
+
+      //        
+      void refresh_zrange(Index2L const & idx)
+      {
+         Column<Traits> & column = *grid_[idx];
+         rectangle_2 const cell_bound = grid_.bigcellraster(idx.big).domain(idx.small);
+
+         range_2 zrange;
+         std::vector<point_3> clipped;
+
+         for (size_t i = 0; i != column.faces().size(); ++i)
+         {
+            triangle_3 const tr = traits_.getTriangle(column.faces()[i]);
+
+            clipped.clear();
+            if (!cull(tr, cell_bound, clipped))
+            {
+               //   
+               clipped.assign(1, tr[0]);
+               clipped.push_back(tr[1]);
+               clipped.push_back(tr[2]);
+            }
+
+            for (size_t j = 0; j != clipped.size(); ++j)
+               zrange.unite(clipped[j].z);
+         }
+
+         //     
+         column.zrange() = zrange;
+      }
 
    private:
       Traits const & traits_;
       Grid_           grid_;
+
+      // ,    
+      std::vector<Index2L> dirty_;
    };
 
    template <class Stream, class Traits>
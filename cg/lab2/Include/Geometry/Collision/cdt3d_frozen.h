@@ -0,0 +1,252 @@
+#pragma   once
+
+#include <vector>
+
+#include "Geometry\Collision\cdt3D.h"
+#include "Geometry\Collision\triangle_packet.h"
+
+/*
+FrozenCollision3D:
+
+Collision3D,      .
+       ,   small cell'  ,
+ small cell      ,     .
+   Column  ,   lock'.
+
+   Collision3D<Traits>       cdt(traits, p, q);
+   FrozenCollision3D<Traits> frozen(cdt);    // cdt    
+
+  ,   Collision3D (cdt::algos), small cell    
+ Column: if (column), column->faces()[i], column->zrange().
+ shootRay       4  cdt::triangle_packet4,
+    4  (shoot_ray_in_column ).
+*/
+
+namespace cg
+{
+   template <class FaceId>
+      struct frozen_column
+   {
+      typedef FaceId face_id;
+
+      //    
+      struct Faces
+      {
+         typedef face_id const * const_iterator;
+
+         size_t          size ()                const { return count_; }
+         bool            empty()                const { return count_ == 0; }
+         face_id const & operator [] (size_t i) const { Assert(i < count_); return first_[i]; }
+
+         const_iterator  begin()                const { return first_; }
+         const_iterator  end  ()                const { return first_ + count_; }
+
+      private:
+         friend struct frozen_column;
+
+         face_id const * first_;
+         unsigned        count_;
+      };
+
+      frozen_column()
+         :   packets_(NULL)
+      {
+         faces_.first_ = NULL;
+         faces_.count_ = 0;
+      }
+
+      //  ,    - ;        ,
+      //  zrange  
+      SAFE_BOOL_OPERATOR(!zrange_.empty())
+
+      frozen_column const * operator -> () const { return this; }
+
+      range_2 const & zrange() const { return zrange_; }
+      Faces   const & faces () const { return faces_;  }
+
+      //  i   packets()[i / 4],  i % 4
+      cdt::triangle_packet4 const * packets() const { return packets_; }
+
+      void assign(range_2 const & zrange, face_id const * first, size_t count, cdt::triangle_packet4 const * packets)
+      {
+         zrange_       = zrange;
+         faces_.first_ = first;
+         faces_.count_ = (unsigned)count;
+         packets_      = packets;
+      }
+
+   private:
+      Faces                         faces_;
+      cdt::triangle_packet4 const * packets_;
+      range_2                       zrange_;
+   };
+
+   // shoot_ray_in_column  shoot_ray.h   :
+   //     4   float,    
+   //     double.
+   //  cg,    cdt,    ADL  shoot_ray::Processor
+   template <class Traits, class FaceId>
+      bool shoot_ray_in_column(Traits const & traits, frozen_column<FaceId> const & column,
+                               point_3 const & org, point_3 const & dir, bool nobackface,
+                               cdt::triangle_filter_t const & filter,
+                               double & ratio, FaceId & face, barycentric_coords & bc)
+   {
+      size_t const size = column.faces().size();
+      size_t const packets = (size + 3) / 4;
+
+      float  best   = FLT_MAX;
+      size_t best_i = size;
+
+      for (size_t p = 0; p != packets; ++p)
+      {
+         __m128 const t = cdt::ray_packet_mt(column.packets()[p], org, dir, nobackface);
+
+         int mask = _mm_movemask_ps(_mm_cmplt_ps(t, _mm_set1_ps(best)));
+         if (!mask)
+            continue;
+
+         float ts[4];
+         _mm_storeu_ps(ts, t);
+
+         for (int lane = 0; lane != 4; ++lane)
+         {
+            size_t const i = 4 * p + lane;
+            if ((mask & (1 << lane)) && i < size && ts[lane] < best && filter(column.faces()[i]))
+            {
+               best   = ts[lane];
+               best_i = i;
+            }
+         }
+      }
+
+      if (best_i == size)
+         return false;
+
+      face = column.faces()[best_i];
+
+      if (cdt::ray_triangle_mt(traits.getTriangle(face), org, dir, ratio, bc) == 0)
+      {
+         ratio    = best;
+         bc.alpha = bc.beta = 0;
+      }
+
+      // float  double      
+      make_max(ratio, 0.);
+      make_min(ratio, 1.);
+      make_max(bc.alpha, 0.);
+      make_max(bc.beta,  0.);
+      if (bc.alpha + bc.beta > 1)
+         bc.alpha = 1 - bc.beta;
+
+      return true;
+   }
+
+   template <class Traits>
+      struct frozen_cdt_grid
+   {
+      typedef Grid2L< frozen_column<typename Traits::face_id> >  value;
+   };
+
+   template <class Traits>
+      struct FrozenCollision3D
+         :   cdt::algos < typename frozen_cdt_grid<Traits>::value, Traits, FrozenCollision3D<Traits> >
+   {
+      typedef typename Traits::face_id                  face_id;
+      typedef typename frozen_cdt_grid<Traits>::value   Grid_;
+      typedef Grid_                                     grid_type;
+
+      explicit FrozenCollision3D(Collision3D<Traits> const & source)
+         :   traits_ (source.traits())
+         ,   grid_   (source.grid())
+      {
+         typedef typename Collision3D<Traits>::grid_type source_grid;
+         typedef typename source_grid::bigcell_type    source_bigcell;
+
+         source_grid const & src = source.grid();
+         point_2i    const   ext = src.extents();
+
+         // 1.   
+         size_t total = 0;
+         for (rectangle_2i::iterator cell(rectangle_by_extents(ext)); cell; ++cell)
+         {
+            source_bigcell const & bcell = src.at(*cell);
+            if (!bcell)
+               continue;
+
+            for (typename source_bigcell::const_iterator it = bcell.begin(); it != bcell.end(); ++it)
+               if (*it)
+                  total += (*it)->faces().size();
+         }
+
+         // 2.   ,  small cell'  ,   
+         faces_.resize(total);
+         face_id * out = faces_.empty() ? NULL : &faces_[0];
+
+         packets_.resize(packets_count(src));
+         cdt::triangle_packet4 * packet = packets_.empty() ? NULL : &packets_[0];
+
+         for (rectangle_2i::iterator cell(rectangle_by_extents(ext)); cell; ++cell)
+         {
+            source_bigcell const & bcell = src.at(*cell);
+            if (!bcell)
+               continue;
+
+            typename Grid_::bigcell_type & frozen = grid_.at(*cell);
+
+            for (typename source_bigcell::const_iterator it = bcell.begin(); it != bcell.end(); ++it)
+            {
+               if (!*it)
+                  continue;
+
+               Column<Traits> const & column = **it;
+
+               size_t const count = column.faces().size();
+
+               std::copy(column.faces().begin(), column.faces().end(), out);
+               frozen.at(bcell.index(it)).assign(column.zrange(), out, count, packet);
+
+               for (size_t i = 0; i != count; ++i)
+                  packet[i / 4].set((int)(i % 4), traits_.getTriangle(out[i]));
+
+               out    += count;
+               packet += (count + 3) / 4;
+            }
+         }
+      }
+
+      Grid_  const & grid  () const { return grid_;   }
+      Traits const & traits() const { return traits_; }
+
+      //     ,  
+      size_t faces_count() const { return faces_.size(); }
+
+   private:
+      //   n   (n + 3) / 4 
+      template <class SourceGrid>
+         static size_t packets_count(SourceGrid const & src)
+      {
+         size_t count = 0;
+         for (rectangle_2i::iterator cell(rectangle_by_extents(src.extents())); cell; ++cell)
+         {
+            typename SourceGrid::bigcell_type const & bcell = src.at(*cell);
+            if (!bcell)
+               continue;
+
+            for (typename SourceGrid::bigcell_type::const_iterator it = bcell.begin(); it != bcell.end(); ++it)
+               if (*it)
+                  count += ((*it)->faces().size() + 3) / 4;
+         }
+         return count;
+      }
+
+      // small cell'   faces_  packets_
+      FrozenCollision3D(FrozenCollision3D const &);
+      void operator = (FrozenCollision3D const &);
+
+   private:
+      Traits const &                        traits_;
+      Grid_                                 grid_;
+      std::vector<face_id>                  faces_;
+      std::vector<cdt::triangle_packet4>    packets_;
+   };
+}
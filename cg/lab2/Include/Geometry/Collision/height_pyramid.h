@@ -0,0 +1,327 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "triangle_filter.h"
+
+/*
+HeightPyramid:
+
+     Collision3D ( FrozenCollision3D)
+      .
+
+ 0 -     ,   - 2x2  .
+getHeightRangeInRect       ,   
+   ;   ,   Collision3D::getHeightRangeInRect.
+
+    ,     ( ), 
+ ; shootVertical        
+,    Collision3D::shootVertical.
+
+     ,  addFace/removeFace  ..  update.
+*/
+
+namespace cg
+{
+   template <class Collision>
+      struct HeightPyramid
+   {
+      typedef typename Collision::face_id                 face_id;
+      typedef typename Collision::grid_type               grid_type;
+      typedef typename Collision::VertIntersectionResult  VertIntersectionResult;
+
+      explicit HeightPyramid(Collision const & collision)
+         :   collision_ (collision)
+      {
+         point_2i const ext = grid().extents();
+
+         // ,   
+         for (point_2i lext = ext; ; lext = point_2i((lext.x + 1) / 2, (lext.y + 1) / 2))
+         {
+            levels_.push_back(level(lext));
+            if (lext.x <= 1 && lext.y <= 1)
+               break;
+         }
+
+         slots_.resize(ext.x * ext.y);
+         planes_.resize(ext.x * ext.y);
+
+         build(point_2i(0, 0), ext);
+      }
+
+      //  ,  collision.getHeightRangeInRect
+      range_2 getHeightRangeInRect(rectangle_2 const & rect) const
+      {
+         point_2i const ext = grid().extents();
+         point_2  const lo  = grid().world2local(rect.lo());
+         point_2  const hi  = grid().world2local(rect.hi());
+
+         //    
+         point_2i ilo = ceil (lo);
+         point_2i ihi = floor(hi);
+
+         make_max(ilo.x, 0); make_max(ilo.y, 0);
+         make_min(ihi.x, ext.x); make_min(ihi.y, ext.y);
+
+         if (ilo.x >= ihi.x || ilo.y >= ihi.y)
+            return collision_.getHeightRangeInRect(rect);
+
+         range_2 res;
+         query(levels_.size() - 1, point_2i(0, 0), ilo, ihi, res);
+
+         //   
+         point_2 const wlo = grid().local2world(point_2(ilo));
+         point_2 const whi = grid().local2world(point_2(ihi));
+
+         if (rect.lo().y < wlo.y)
+            res |= collision_.getHeightRangeInRect(rectangle_2(rect.lo(), point_2(rect.hi().x, wlo.y)));
+         if (whi.y < rect.hi().y)
+            res |= collision_.getHeightRangeInRect(rectangle_2(point_2(rect.lo().x, whi.y), rect.hi()));
+         if (rect.lo().x < wlo.x)
+            res |= collision_.getHeightRangeInRect(rectangle_2(point_2(rect.lo().x, wlo.y), point_2(wlo.x, whi.y)));
+         if (whi.x < rect.hi().x)
+            res |= collision_.getHeightRangeInRect(rectangle_2(point_2(whi.x, wlo.y), point_2(rect.hi().x, whi.y)));
+
+         return res;
+      }
+
+      //  ,  collision.shootVertical
+      bool shootVertical(point_2 const & pt, double hFrom, double hTo, VertIntersectionResult & result,
+                         cdt::triangle_filter_t const & f = cdt::dummy_triangle_filter) const
+      {
+         plane const * p = find_plane(pt);
+         if (!p)
+            return collision_.shootVertical(pt, hFrom, hTo, result, f);
+
+         result.height = hFrom < hTo ? inf() : -inf();
+
+         if (!f(p->face))
+            return false;
+
+         double const dx = pt.x - p->org.x;
+         double const dy = pt.y - p->org.y;
+
+         barycentric_coords bc;
+         bc.alpha = p->alpha.x * dx + p->alpha.y * dy;
+         bc.beta  = p->beta .x * dx + p->beta .y * dy;
+
+         double const h = p->org.z + bc.alpha * p->dz.x + bc.beta * p->dz.y;
+         if (!range_2(hFrom, hTo).contains(h))
+            return false;
+
+         result.height = h;
+         result.face   = p->face;
+         result.bc     = bc;
+         return true;
+      }
+
+      //  ,   area,    collision
+      void update(rectangle_2 const & area)
+      {
+         point_2i const ext = grid().extents();
+
+         point_2i lo = floor(grid().world2local(area.lo()));
+         point_2i hi = floor(grid().world2local(area.hi()));
+
+         make_max(lo.x, 0); make_max(lo.y, 0);
+         make_min(hi.x, ext.x - 1); make_min(hi.y, ext.y - 1);
+         ++hi.x; ++hi.y;
+
+         if (lo.x < hi.x && lo.y < hi.y)
+            build(lo, hi);
+      }
+
+      Collision const & collision() const { return collision_; }
+
+   private:
+      static double inf () { return std::numeric_limits<double>::max(); }
+
+      // h(pt) = org.z + alpha(pt) * dz.x + beta(pt) * dz.y, alpha  beta   pt - org
+      struct plane
+      {
+         face_id  face;
+         point_3  org;
+         point_2  alpha, beta;
+         point_2  dz;
+      };
+
+      struct level
+      {
+         explicit level(point_2i const & ext) : ext(ext), ranges(ext.x * ext.y) {}
+
+         range_2 const & at(point_2i const & idx) const { return ranges[idx.y * ext.x + idx.x]; }
+         range_2       & at(point_2i const & idx)       { return ranges[idx.y * ext.x + idx.x]; }
+
+         point_2i             ext;
+         std::vector<range_2> ranges;
+      };
+
+      grid_type const & grid() const { return collision_.grid(); }
+
+      //   [lo, hi)  0  ,   
+      void build(point_2i lo, point_2i hi)
+      {
+         for (int y = lo.y; y != hi.y; ++y)
+            for (int x = lo.x; x != hi.x; ++x)
+               build_bigcell(point_2i(x, y));
+
+         for (size_t l = 1; l != levels_.size(); ++l)
+         {
+            lo = point_2i(lo.x / 2, lo.y / 2);
+            hi = point_2i((hi.x + 1) / 2, (hi.y + 1) / 2);
+
+            level const & below = levels_[l - 1];
+            level       & cur   = levels_[l];
+
+            for (int y = lo.y; y != hi.y; ++y)
+               for (int x = lo.x; x != hi.x; ++x)
+               {
+                  range_2 r;
+                  for (int k = 0; k != 4; ++k)
+                  {
+                     point_2i const child(2 * x + (k & 1), 2 * y + (k >> 1));
+                     if (child.x < below.ext.x && child.y < below.ext.y)
+                        r |= below.at(child);
+                  }
+                  cur.at(point_2i(x, y)) = r;
+               }
+         }
+      }
+
+      void build_bigcell(point_2i const & big)
+      {
+         typedef typename grid_type::bigcell_type bigcell_type;
+
+         int const b = big.y * levels_[0].ext.x + big.x;
+
+         range_2             & r      = levels_[0].at(big);
+         std::vector<plane>  & planes = planes_[b];
+         std::vector<int>    & slots  = slots_[b];
+
+         r = range_2();
+         planes.clear();
+
+         //        (Collision3D::addFace)
+         bigcell_type const & bcell = grid().at(big);
+         slots.assign(bcell ? bcell.size() : 0, -1);
+         if (!bcell)
+            return;
+
+         raster_2 const raster = grid().bigcellraster(big);
+
+         for (typename bigcell_type::const_iterator it = bcell.begin(); it != bcell.end(); ++it)
+         {
+            int & slot = slots[it - bcell.begin()];
+
+            if (!*it)
+               continue;
+
+            r |= (*it)->zrange();
+
+            plane p;
+            if ((*it)->faces().size() == 1 && make_plane((*it)->faces()[0], raster.domain(bcell.index(it)), p))
+            {
+               slot = (int)planes.size();
+               planes.push_back(p);
+            }
+         }
+      }
+
+      //  ,     
+      bool make_plane(face_id face, rectangle_2 const & cell, plane & p) const
+      {
+         triangle_3 const tr = collision_.traits().getTriangle(face);
+
+         point_2 const e1 = point_2(tr[1]) - point_2(tr[0]);
+         point_2 const e2 = point_2(tr[2]) - point_2(tr[0]);
+
+         double const det = e1.x * e2.y - e2.x * e1.y;
+         if (eq(det, 0.))
+            return false;
+
+         p.face  = face;
+         p.org   = tr[0];
+         p.alpha = point_2( e2.y / det, -e2.x / det);
+         p.beta  = point_2(-e1.y / det,  e1.x / det);
+         p.dz    = point_2(tr[1].z - tr[0].z, tr[2].z - tr[0].z);
+
+         point_2 const corners[] = { cell.xy(), cell.xY(), cell.Xy(), cell.XY() };
+         for (int i = 0; i != 4; ++i)
+         {
+            double const dx = corners[i].x - p.org.x;
+            double const dy = corners[i].y - p.org.y;
+            double const a  = p.alpha.x * dx + p.alpha.y * dy;
+            double const b  = p.beta .x * dx + p.beta .y * dy;
+
+            if (a < 0 || b < 0 || a + b > 1)
+               return false;
+         }
+
+         return true;
+      }
+
+      plane const * find_plane(point_2 const & pt) const
+      {
+         point_2  const local = grid().world2local(pt);
+         point_2i const big   = floor(local);
+
+         if (!grid().contains(big))
+            return NULL;
+
+         typename grid_type::bigcell_type const & bcell = grid().at(big);
+         if (!bcell)
+            return NULL;
+
+         point_2i const sext  = bcell.extents();
+         point_2i       small = floor((local - big) & sext);
+
+         make_min(small.x, sext.x - 1);
+         make_min(small.y, sext.y - 1);
+
+         int const b    = big.y * levels_[0].ext.x + big.x;
+         size_t const i = &bcell.at(small) - bcell.begin();
+         if (i >= slots_[b].size())
+            return NULL;
+
+         int const slot = slots_[b][i];
+         return slot < 0 ? NULL : &planes_[b][slot];
+      }
+
+      //  node  l    [node << l, (node + 1) << l)
+      void query(size_t l, point_2i const & node, point_2i const & lo, point_2i const & hi, range_2 & res) const
+      {
+         point_2i const nlo(node.x << l, node.y << l);
+         point_2i       nhi((node.x + 1) << l, (node.y + 1) << l);
+
+         make_min(nhi.x, levels_[0].ext.x);
+         make_min(nhi.y, levels_[0].ext.y);
+
+         if (nhi.x <= lo.x || nhi.y <= lo.y || hi.x <= nlo.x || hi.y <= nlo.y)
+            return;
+
+         if (l == 0 || (lo.x <= nlo.x && lo.y <= nlo.y && nhi.x <= hi.x && nhi.y <= hi.y))
+         {
+            res |= levels_[l].at(node);
+            return;
+         }
+
+         level const & below = levels_[l - 1];
+         for (int k = 0; k != 4; ++k)
+         {
+            point_2i const child(2 * node.x + (k & 1), 2 * node.y + (k >> 1));
+            if (child.x < below.ext.x && child.y < below.ext.y)
+               query(l - 1, child, lo, hi, res);
+         }
+      }
+
+   private:
+      Collision const & collision_;
+
+      std::vector<level> levels_;
+
+      // planes_[big][slots_[big][small]], -1 -  
+      std::vector<std::vector<int> >    slots_;
+      std::vector<std::vector<plane> >  planes_;
+   };
+}
@@ -1,5 +1,8 @@
 #pragma   once
 
+#include <algorithm>
+#include <vector>
+
 #include "geometry/grid1L.h"
 #include "calc_barycentric_coords_3d.h"
 
@@ -9,6 +12,60 @@ namespace cg
 {
     namespace cdt
     {
+        //    org + dir * t, t in [0, 1],   .
+        // Column - -    Column  cdt3D.h;  FrozenCollision3D
+        //  ,    4   (cdt3d_frozen.h)
+        template <class Traits, class Column>
+            bool shoot_ray_in_column(Traits const & traits, Column const & column,
+                                     point_3 const & org, point_3 const & dir, bool nobackface,
+                                     triangle_filter_t const & filter,
+                                     double & ratio, typename Traits::face_id & face, barycentric_coords & bc)
+        {
+            bool found = false;
+
+            for (size_t i = 0, size = column->faces().size(); i != size; ++i) 
+            {
+                //     
+                //    
+                typename Traits::face_id const tr_idx = column->faces()[i];
+
+                double r;
+                if (filter(tr_idx)
+                   && traits.intersect(tr_idx, org, dir, r, nobackface)
+                   && (!found || r < ratio))  
+                {
+                    found = true;
+                    ratio = r;
+                    face  = tr_idx;
+                }
+            }
+
+            if (!found)
+                return false;
+
+            //   
+            if( !calc_barycentric_coords_3d( traits.getTriangle( face ), org + dir * ratio, bc ) )
+            {
+               //    - 
+               if( !cg::eq( bc.alpha + bc.beta, 1, 1e-4 ) )
+               {
+                  Assert( !"   " );
+               }
+
+               //  ?
+               if( bc.alpha < 0 )
+                  bc.alpha = 0;
+
+               if( bc.beta < 0 )
+                  bc.beta = 0;
+
+               if( bc.alpha + bc.beta > 1 )
+               bc.alpha = 1 - bc.beta;
+            }
+
+            return true;
+        }
+
         template <class Grid, class Traits, class Derived>
             struct shoot_ray
         {
@@ -20,6 +77,18 @@ namespace cg
                 cg::barycentric_coords bc;
             };
 
+            struct RayQuery
+            {
+                RayQuery() : nobackface(false), filter(NULL) {}
+                RayQuery(point_3 const &from, point_3 const &to, bool nobackface = false, triangle_filter_t const * filter = NULL)
+                    : from(from), to(to), nobackface(nobackface), filter(filter)
+                {}
+
+                point_3 from, to;
+                bool    nobackface;
+                triangle_filter_t const * filter;   // NULL -  
+            };
+
             bool shootRay (point_3 const &from, point_3 const &to, bool nobackface, IntersectionParams &result,
                            triangle_filter_t const & filter = dummy_triangle_filter) const
             {
@@ -37,12 +106,77 @@ namespace cg
                 return visit(grid(), clipped_seg2, shootray);
             }
 
+            //  : results[i], hits[i] -  ,    shootRay  rays[i].
+            //         ,  
+            //      ,   parallel   .
+            //       .
+            //   .
+            size_t shootRays (RayQuery const * rays, size_t count, IntersectionParams * results, bool * hits,
+                              bool parallel = true) const
+            {
+                int const n = (int)count;
+
+                std::vector<ray_order> order(n);
+                for (int i = 0; i != n; ++i)
+                {
+                    order[i].key = order_key(rays[i]);
+                    order[i].ray = i;
+                }
+                std::sort(order.begin(), order.end());
+
+                triangle_filter_t const all_faces(dummy_triangle_filter);
+
+                int found = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : found) if (parallel)
+#endif
+                for (int k = 0; k < n; ++k)
+                {
+                    int const        i   = order[k].ray;
+                    RayQuery const & ray = rays[i];
+
+                    hits[i] = shootRay(ray.from, ray.to, ray.nobackface, results[i], ray.filter ? *ray.filter : all_faces);
+                    if (hits[i])
+                        ++found;
+                }
+
+                return found;
+            }
+
         private:
 
             Derived const & self () const { return static_cast<Derived const &>(*this); }
 
             Grid & grid() const { return const_cast<Grid&>(self().grid()); }
 
+            struct ray_order
+            {
+                unsigned key;
+                int      ray;
+
+                bool operator < (ray_order const & other) const
+                {
+                    return key != other.key ? key < other.key : ray < other.ray;
+                }
+            };
+
+            // ,    ,   
+            unsigned order_key (RayQuery const & ray) const
+            {
+                point_2i const ext  = grid().extents();
+                point_2i       cell = floor(grid().world2local(point_2(ray.from.x, ray.from.y)));
+
+                make_max(cell.x, 0);
+                make_max(cell.y, 0);
+                make_min(cell.x, ext.x - 1);
+                make_min(cell.y, ext.y - 1);
+
+                point_3 const dir = ray.to - ray.from;
+                unsigned const octant = (dir.x < 0 ? 1 : 0) | (dir.y < 0 ? 2 : 0) | (dir.z < 0 ? 4 : 0);
+
+                return (unsigned)(cell.y * ext.x + cell.x) * 8 + octant;
+            }
+
             struct Processor : grid2l_visitor_base<Grid, Processor>
             {
                Processor(Traits const &traits, cg::segment_3 const & orig_seg, point_3 const &from, 
@@ -71,50 +205,17 @@ namespace cg
                         if (has_intersection(hray, column->zrange()))
                         {
                             //     
-                            result_.ratio = FLOAT_ETERNITY;
+                            double  ratio;
+                            face_id face;
+                            cg::barycentric_coords bc;
 
-                            double ratio;
-
-                            for (size_t i = 0, size = column->faces().size(); i != size; ++i) 
+                            if (shoot_ray_in_column(traits_, column, org_, dir_, nobackface_, filter_, ratio, face, bc))
                             {
-                                //     
-                                //    
-                                int tr_idx = column->faces()[i];
-                                triangle_3 tr = traits_.getTriangle( tr_idx );
-                                if (filter_(tr_idx)
-                                   && traits_.intersect(tr_idx, org_, dir_, ratio, nobackface_)
-                                   && ratio < result_.ratio)  
-                                {
-                                    //   
-                                    point_3 const ipt = org_ + dir_ * ratio;
-
-                                    result_.ratio = orig_seg_( ipt );
-                                    result_.face  = column->faces()[i];    
-                                    
-                                    //   
-                                    if( !calc_barycentric_coords_3d( tr, ipt, result_.bc ) )
-                                    {
-                                       //    - 
-                                       if( !cg::eq( result_.bc.alpha + result_.bc.beta, 1, 1e-4 ) )
-                                       {
-                                          Assert( !"   " );
-                                       }
-
-                                       //  ?
-                                       if( result_.bc.alpha < 0 )
-                                          result_.bc.alpha = 0;
-
-                                       if( result_.bc.beta < 0 )
-                                          result_.bc.beta = 0;
-
-                                       if( result_.bc.alpha + result_.bc.beta > 1 )
-                                       result_.bc.alpha = 1 - result_.bc.beta;
-                                    }
-                                }
+                                result_.ratio = orig_seg_( org_ + dir_ * ratio );
+                                result_.face  = face;
+                                result_.bc    = bc;
+                                return true;
                             }
-
-                            // eq(FLOAT_ETERNITY)
-                            return result_.ratio != FLOAT_ETERNITY;
                         }
                     }
 
@@ -123,7 +224,7 @@ namespace cg
 
             private:
                 Traits const & traits_;
-                point_3 const& org_;
+                point_3 const  org_;
                 point_3 const  dir_;
                 cg::segment_3  orig_seg_;
                 bool           nobackface_;
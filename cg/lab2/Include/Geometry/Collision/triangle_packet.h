@@ -0,0 +1,127 @@
+#pragma once
+
+#include <float.h>
+#include <xmmintrin.h>
+
+#include "geometry\triangle_raster_aux.h"
+
+//      ̸ - :   double   4    SSE.
+//
+//  org + dir * t, t in [0, 1]; bc.alpha, bc.beta -   1  2,   calc_barycentric_coords_3d.
+// nobackface  ,   (v1 - v0) ^ (v2 - v0)   .
+
+namespace cg
+{
+    namespace cdt
+    {
+        // det == 0,       
+        inline double ray_triangle_mt(triangle_3 const & tr, point_3 const & org, point_3 const & dir,
+                                      double & t, barycentric_coords & bc)
+        {
+            point_3 const e1 = tr[1] - tr[0];
+            point_3 const e2 = tr[2] - tr[0];
+
+            point_3 const p   = dir ^ e2;
+            double  const det = e1 * p;
+
+            if (det == 0)
+                return 0;
+
+            double  const inv = 1 / det;
+            point_3 const s   = org - tr[0];
+            point_3 const q   = s ^ e1;
+
+            bc.alpha = (s * p)   * inv;
+            bc.beta  = (dir * q) * inv;
+            t        = (e2 * q)  * inv;
+
+            return det;
+        }
+
+        // 4   SoA,   float  org ( 0  ),
+        //       .      .
+        struct triangle_packet4
+        {
+            float   v0[3][4];
+            float   e1[3][4];
+            float   e2[3][4];
+            point_3 org;
+
+            triangle_packet4()
+            {
+                for (int c = 0; c != 3; ++c)
+                    for (int l = 0; l != 4; ++l)
+                        v0[c][l] = e1[c][l] = e2[c][l] = 0;
+            }
+
+            void set(int lane, triangle_3 const & tr)
+            {
+                if (lane == 0)
+                    org = tr[0];
+
+                point_3 const v  = tr[0] - org;
+                point_3 const a  = tr[1] - tr[0];
+                point_3 const b  = tr[2] - tr[0];
+
+                v0[0][lane] = (float)v.x; v0[1][lane] = (float)v.y; v0[2][lane] = (float)v.z;
+                e1[0][lane] = (float)a.x; e1[1][lane] = (float)a.y; e1[2][lane] = (float)a.z;
+                e2[0][lane] = (float)b.x; e2[1][lane] = (float)b.y; e2[2][lane] = (float)b.z;
+            }
+        };
+
+        // t  4 , FLT_MAX -  
+        inline __m128 ray_packet_mt(triangle_packet4 const & pk, point_3 const & org, point_3 const & dir, bool nobackface)
+        {
+            __m128 const ox = _mm_set1_ps((float)(org.x - pk.org.x));
+            __m128 const oy = _mm_set1_ps((float)(org.y - pk.org.y));
+            __m128 const oz = _mm_set1_ps((float)(org.z - pk.org.z));
+
+            __m128 const dx = _mm_set1_ps((float)dir.x);
+            __m128 const dy = _mm_set1_ps((float)dir.y);
+            __m128 const dz = _mm_set1_ps((float)dir.z);
+
+            __m128 const e1x = _mm_loadu_ps(pk.e1[0]), e1y = _mm_loadu_ps(pk.e1[1]), e1z = _mm_loadu_ps(pk.e1[2]);
+            __m128 const e2x = _mm_loadu_ps(pk.e2[0]), e2y = _mm_loadu_ps(pk.e2[1]), e2z = _mm_loadu_ps(pk.e2[2]);
+
+            // p = dir ^ e2
+            __m128 const px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+            __m128 const py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+            __m128 const pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+            __m128 const det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+            __m128 const inv = _mm_div_ps(_mm_set1_ps(1.f), det);
+
+            // s = org - v0
+            __m128 const sx = _mm_sub_ps(ox, _mm_loadu_ps(pk.v0[0]));
+            __m128 const sy = _mm_sub_ps(oy, _mm_loadu_ps(pk.v0[1]));
+            __m128 const sz = _mm_sub_ps(oz, _mm_loadu_ps(pk.v0[2]));
+
+            // q = s ^ e1
+            __m128 const qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+            __m128 const qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+            __m128 const qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+            __m128 const u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv);
+            __m128 const v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+            __m128 const t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+
+            __m128 const zero = _mm_setzero_ps();
+            __m128 const one  = _mm_set1_ps(1.f);
+            __m128 const eps  = _mm_set1_ps(1e-5f);
+
+            // det > 0 -  
+            __m128 const facing = nobackface
+                ? _mm_cmpgt_ps(det, zero)
+                : _mm_cmpneq_ps(det, zero);
+
+            __m128 hit = facing;
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(u, _mm_sub_ps(zero, eps)));
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(v, _mm_sub_ps(zero, eps)));
+            hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_add_ps(one, eps)));
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(t, zero));
+            hit = _mm_and_ps(hit, _mm_cmple_ps(t, one));
+
+            return _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, _mm_set1_ps(FLT_MAX)));
+        }
+    }
+}
@@ -56,7 +56,8 @@ namespace cg
                 template <class State>
                     bool operator () (State &, typename Grid::smallcell_type const & column)
                 {
-                    if (column)
+                    //      zrange
+                    if (column && has_intersection(range_2(hFrom_, hTo_), column->zrange()))
                     {
                         for (unsigned i = 0; i < column->faces().size(); ++i)
                         {
@@ -9,7 +9,7 @@
 #include "Geometry\empty.h"
 #include "Geometry\clockwise.h"
 
-#include "Geometry\cgal_predicates.h"
+#include "Geometry\default_predicates.h"
 
 #include "list_on_vector.h"
 
@@ -582,11 +582,12 @@ public:
       }
    };
 
-   struct RobustOrientationPredicate
+   template< class Predicates >
+      struct PolicyOrientationPredicate
    {
       EdgesPairOrientation operator ()( cg::point_2 const &origin, cg::point_2 const &a, cg::point_2 const &b ) const
       {
-         VecOrientation orien = robust_orientation(b, origin, a);
+         VecOrientation orien = Predicates::orientation(b, origin, a);
          switch (orien)
          {
          case VO_LEFT: return DCEL::EPO_LEFT;
@@ -594,13 +595,15 @@ public:
          }
 
          // VO_COLLINEAR
-         if (robust_collinear_are_ordered_along_line(a, origin, b))
+         if (Predicates::collinear_are_ordered_along_line(a, origin, b))
             return DCEL::EPO_OPPOSITELY_DIRECTED;
 
          return DCEL::EPO_CODIRECTIONAL;
       }
    };
 
+   typedef PolicyOrientationPredicate< default_predicates > RobustOrientationPredicate;
+
    // Finds next edge in destination vertex for line (origin, destination)
    template< class OrientationPredicate >
       int findEdgeNextToLine( size_t origin, size_t destination, OrientationPredicate pred, bool ignoreHoles = true ) const
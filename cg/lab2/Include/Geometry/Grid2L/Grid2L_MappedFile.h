@@ -0,0 +1,336 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <boost/noncopyable.hpp>
+
+#include "Geometry\Grid2L\Grid2L_Impl.h"
+#include "Geometry\Grid2L\Grid2L_Mapped.h"
+
+// Grid2L<T> saved as one flat image that is used in place as MappedGrid2L<T>.
+//
+//    save_mapped_grid2l("index.g2l", grid);
+//
+//    mapped_grid2l_file<T> file("index.g2l");
+//    if (file)
+//       visit(file.grid(), rect, proc);
+//
+// An image is checked when it is opened: the header, and every self-relative pointer down to
+// the small cells has to stay inside the image, so a truncated or corrupt file is rejected
+// instead of being read out of range. The check is linear in the number of big cells.
+//
+// T has to be POD, it is copied byte by byte. The headers of the grid and of the big cells
+// are not stored, the small cells go rowwise whatever Dir the source grid uses.
+// All pointers inside the image are self-relative (see mapped_ptr.h), so the file is mapped
+// read-only and shared between processes through the page cache, nothing is fixed up on load.
+//
+// Image layout, every block 8-aligned:
+//    mapped_grid2l_header
+//    MappedGrid2L<T>                      - transform and pointer to the big cells
+//    point_2i, bigcell_type[w * h]        - big cells, rowwise
+//    mapped_array_2d<T>, point_2i, T[n]   - small cells of each subdivided big cell
+
+namespace cg
+{
+   struct mapped_grid2l_header
+   {
+      enum { current_version = 1 };
+
+      char     magic[4];     // "G2LM"
+      unsigned version;
+      unsigned smallcell_size;
+      unsigned bigcell_size;
+      __int64  size;         // of the whole image
+      __int64  root;         // offset of MappedGrid2L
+   };
+
+   namespace mapped_grid2l_details
+   {
+      inline __int64 align(__int64 pos) { return (pos + 7) & ~(__int64)7; }
+
+      inline bool check_header(char const * data, __int64 size, unsigned smallcell_size, unsigned bigcell_size)
+      {
+         if (size < (__int64)sizeof(mapped_grid2l_header))
+            return false;
+
+         mapped_grid2l_header const & hdr = *reinterpret_cast<mapped_grid2l_header const *>(data);
+         return
+               memcmp(hdr.magic, "G2LM", 4) == 0
+            && hdr.version        == mapped_grid2l_header::current_version
+            && hdr.smallcell_size == smallcell_size
+            && hdr.bigcell_size   == bigcell_size
+            && hdr.size           == size
+            && hdr.root           >= (__int64)sizeof(mapped_grid2l_header)
+            && hdr.root           <  size;
+      }
+
+      // position of the target of p, -1 unless [pos, pos + len) lies in the image
+      inline __int64 target(char const * data, __int64 size, ofs_ptr_s const & p, __int64 len)
+      {
+         if (!p.offset())
+            return -1;
+
+         __int64 const self = reinterpret_cast<char const *>(&p) - data;
+         if (p.offset() < -self || p.offset() > size - self)
+            return -1;
+
+         __int64 const pos = self + p.offset();
+         return len <= size - pos ? pos : -1;
+      }
+
+      // position of the elements of an array stored as point_2i extents and then the elements,
+      // -1 if the array doesn't fit in the image
+      inline __int64 array_target(char const * data, __int64 size, ofs_ptr_s const & p, __int64 elem_size, point_2i & ext)
+      {
+         __int64 const pos = target(data, size, p, sizeof(point_2i));
+         if (pos < 0)
+            return -1;
+
+         ext = *reinterpret_cast<point_2i const *>(data + pos);
+         if (ext.x < 0 || ext.y < 0)
+            return -1;
+
+         __int64 const first = pos + sizeof(point_2i);
+         __int64 const fits  = (size - first) / elem_size;
+         if (ext.x != 0 && ext.y > fits / ext.x)
+            return -1;
+
+         return first;
+      }
+
+      // all pointers of the image after check_header
+      template <class T>
+         bool check_pointers(char const * data, __int64 size)
+      {
+         typedef MappedGrid2L<T>                            mapped_type;
+         typedef typename mapped_type::bigcell_type         mapped_bigcell;
+         typedef mapped_array_2d<T>                         mapped_cells;
+
+         __int64 const root = reinterpret_cast<mapped_grid2l_header const *>(data)->root;
+         if ((__int64)sizeof(mapped_type) > size - root)
+            return false;
+
+         mapped_type const & mgrid = *reinterpret_cast<mapped_type const *>(data + root);
+
+         point_2i ext;
+         __int64 const bigs = array_target(data, size, static_cast<ofs_ptr_s const &>(mgrid), sizeof(mapped_bigcell), ext);
+         if (bigs < 0)
+            return false;
+
+         mapped_bigcell const * bcells = reinterpret_cast<mapped_bigcell const *>(data + bigs);
+         for (int i = 0, n = ext.x * ext.y; i != n; ++i)
+         {
+            ofs_ptr_s const & cells_ptr = bcells[i].ptr();
+            if (!cells_ptr.offset())
+               continue;
+
+            __int64 const cells = target(data, size, cells_ptr, sizeof(mapped_cells));
+            if (cells < 0)
+               return false;
+
+            point_2i sext;
+            if (array_target(data, size, *reinterpret_cast<mapped_cells const *>(data + cells), sizeof(T), sext) < 0)
+               return false;
+         }
+
+         return true;
+      }
+   }
+
+   // image of grid in a memory block
+   template <class T, class BigCell, class GridHeader>
+      void make_mapped_grid2l(Grid2L<T, BigCell, GridHeader> const & grid, std::vector<char> & image)
+   {
+      using namespace mapped_grid2l_details;
+
+      typedef MappedGrid2L<T>                   mapped_type;
+      typedef grid2l_bigcell_mapped<T>          mapped_bigcell;
+      typedef mapped_array_2d<T>                mapped_cells;
+
+      point_2i const ext = grid.extents();
+
+      // 1. layout
+      __int64 const root  = align(sizeof(mapped_grid2l_header));
+      __int64 const bigs  = align(root + sizeof(mapped_type));
+      __int64       pos   = align(bigs + sizeof(point_2i) + sizeof(mapped_bigcell) * ext.x * ext.y);
+
+      std::vector<__int64> smalls(ext.x * ext.y, 0);
+      for (int y = 0; y != ext.y; ++y)
+         for (int x = 0; x != ext.x; ++x)
+         {
+            BigCell const & bcell = grid.at(point_2i(x, y));
+            if (!bcell)
+               continue;
+
+            smalls[y * ext.x + x] = pos;
+            pos = align(pos + sizeof(mapped_cells) + sizeof(point_2i) + sizeof(T) * bcell.size());
+         }
+
+      // 2. fill
+      image.assign((size_t)pos, 0);
+      char * data = &image[0];
+
+      mapped_grid2l_header & hdr = *reinterpret_cast<mapped_grid2l_header *>(data);
+      memcpy(hdr.magic, "G2LM", 4);
+      hdr.version        = mapped_grid2l_header::current_version;
+      hdr.smallcell_size = sizeof(T);
+      hdr.bigcell_size   = sizeof(mapped_bigcell);
+      hdr.size           = pos;
+      hdr.root           = root;
+
+      mapped_type & mgrid = *reinterpret_cast<mapped_type *>(data + root);
+      static_cast<aa_transform &>(mgrid) = grid.tform();
+      static_cast<ofs_ptr_s &>(mgrid).set_ptr(data + bigs);
+
+      *reinterpret_cast<point_2i *>(data + bigs) = ext;
+      mapped_bigcell * mbcells = reinterpret_cast<mapped_bigcell *>(data + bigs + sizeof(point_2i));
+
+      for (int y = 0; y != ext.y; ++y)
+         for (int x = 0; x != ext.x; ++x)
+         {
+            __int64 const at = smalls[y * ext.x + x];
+            if (!at)
+               continue;
+
+            BigCell const & bcell = grid.at(point_2i(x, y));
+            point_2i const  sext  = bcell.extents();
+
+            mapped_cells & cells = *reinterpret_cast<mapped_cells *>(data + at);
+            char * block = data + at + sizeof(mapped_cells);
+
+            cells.set_ptr(block);
+            mbcells[y * ext.x + x].set_ptr(&cells);
+
+            *reinterpret_cast<point_2i *>(block) = sext;
+            T * out = reinterpret_cast<T *>(block + sizeof(point_2i));
+
+            point_2i idx;
+            for (idx.y = 0; idx.y != sext.y; ++idx.y)
+               for (idx.x = 0; idx.x != sext.x; ++idx.x)
+                  new (out++) T(bcell.at(idx));
+         }
+   }
+
+   template <class T, class BigCell, class GridHeader>
+      bool save_mapped_grid2l(char const * path, Grid2L<T, BigCell, GridHeader> const & grid)
+   {
+      std::vector<char> image;
+      make_mapped_grid2l(grid, image);
+
+      FILE * f = fopen(path, "wb");
+      if (!f)
+         return false;
+
+      bool const ok = fwrite(&image[0], 1, image.size(), f) == image.size();
+      return fclose(f) == 0 && ok;
+   }
+
+   // MappedGrid2L<T> over an image in memory, NULL if the image is not of this T or is damaged
+   template <class T>
+      MappedGrid2L<T> const * mapped_grid2l_from_image(char const * data, __int64 size)
+   {
+      typedef MappedGrid2L<T> mapped_type;
+
+      if (!mapped_grid2l_details::check_header(data, size, sizeof(T), sizeof(typename mapped_type::bigcell_type)))
+         return NULL;
+
+      if (!mapped_grid2l_details::check_pointers<T>(data, size))
+         return NULL;
+
+      return reinterpret_cast<mapped_type const *>(data + reinterpret_cast<mapped_grid2l_header const *>(data)->root);
+   }
+
+   // read-only mapping of a whole file
+   struct mapped_file_view : boost::noncopyable
+   {
+      explicit mapped_file_view(char const * path)
+         : data_(NULL), size_(0)
+      {
+#ifdef _WIN32
+         HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+         if (file == INVALID_HANDLE_VALUE)
+            return;
+
+         LARGE_INTEGER size;
+         if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+         {
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping)
+            {
+               data_ = static_cast<char const *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+               size_ = data_ ? size.QuadPart : 0;
+               CloseHandle(mapping);
+            }
+         }
+         CloseHandle(file);
+#else
+         int const fd = open(path, O_RDONLY);
+         if (fd < 0)
+            return;
+
+         struct stat st;
+         if (fstat(fd, &st) == 0 && st.st_size > 0)
+         {
+            void * p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED)
+            {
+               data_ = static_cast<char const *>(p);
+               size_ = st.st_size;
+            }
+         }
+         close(fd);
+#endif
+      }
+
+      ~mapped_file_view()
+      {
+         if (!data_)
+            return;
+#ifdef _WIN32
+         UnmapViewOfFile(data_);
+#else
+         munmap(const_cast<char *>(data_), (size_t)size_);
+#endif
+      }
+
+      char const * data() const { return data_; }
+      __int64      size() const { return size_; }
+
+   private:
+      char const * data_;
+      __int64      size_;
+   };
+
+   // file written by save_mapped_grid2l, mapped for the lifetime of the object
+   template <class T>
+      struct mapped_grid2l_file : boost::noncopyable
+   {
+      typedef MappedGrid2L<T> grid_type;
+
+      explicit mapped_grid2l_file(char const * path)
+         : view_(path)
+         , grid_(view_.data() ? mapped_grid2l_from_image<T>(view_.data(), view_.size()) : NULL)
+      {}
+
+      SAFE_BOOL_OPERATOR(grid_)
+
+      // the image is mapped read-only
+      grid_type const & grid() const { Assert(grid_); return *grid_; }
+
+   private:
+      mapped_file_view  view_;
+      grid_type const * grid_;
+   };
+}
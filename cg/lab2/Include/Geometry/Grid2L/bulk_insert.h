@@ -0,0 +1,211 @@
+#pragma once
+
+#include <vector>
+
+#include "common\omp_utils.h"
+#include "Geometry\Grid1L\HitCounter.h"
+#include "Geometry\Grid2L\Grid2L_Impl.h"
+
+// Multi-threaded bulk loading of a Grid2L.
+//
+//    bulk_insert(grid, p, q, items, inserter);
+//
+// fills the cells exactly like
+//
+//    for (Iter t = p; t != q; ++t)
+//       visit(grid, items.getItem(t), processor(t));
+//
+// with a processor calling inserter(cell, index, t) for every reported small cell, but without locks:
+//    1. the range is cut into chunks, each chunk is rasterized by one thread and
+//       the (small cell, item) pairs are recorded;
+//    2. the pairs are bucketed by big cell: count, prefix sum, scatter;
+//    3. the big cells are filled in parallel, each by one thread.
+// Buckets keep the chunk order and the visiting order inside a chunk, so every small cell
+// receives its items in the same order as with sequential insertion.
+//
+// Iter is only incremented, so segment ids work as well as iterators.
+// From items (the traits of Grid2LInitializer fit):
+//    Item getItem(Iter) const                                 - anything visit(grid, item, proc) accepts
+// From inserter:
+//    void operator () (smallcell_type &, Index2L const &, Iter) const  - puts the item into the cell
+// Both are called concurrently. The inserter sees the cell and its index only, the visitor state
+// (e.g. in_ratio of segment visits) is gone by then. Triangle sides are not reported,
+// as with an inserter whose side processor does nothing.
+
+namespace cg
+{
+   namespace bulk_insert_details
+   {
+      template <class Iter>
+         struct cell_hit
+      {
+         int      big;     // linear index of the big cell
+         point_2i small;
+         Iter     item;
+      };
+
+      struct skip_side
+      {
+         template <class State, class Cell>
+            bool operator () (State const &, Cell &) { return false; }
+      };
+
+      template <class Grid, class Iter>
+         struct hit_recorder
+            : grid2l_visitor_base<Grid, hit_recorder<Grid, Iter> >
+      {
+         hit_recorder(Grid const & grid, std::vector<cell_hit<Iter> > & hits)
+            : grid_(grid), hits_(hits)
+         {}
+
+         template <class State>
+            bool operator () (State const & state, typename Grid::smallcell_type &)
+         {
+            cell_hit<Iter> hit;
+            hit.big   = grid_.to1D(state.big);
+            hit.small = state.small;
+            hit.item  = item;
+            hits_.push_back(hit);
+            return false;
+         }
+
+         typedef skip_side SideProcessor;
+         SideProcessor & side_processor(int, int) { return side_; }
+
+         Iter item;
+
+      private:
+         Grid const                   & grid_;
+         std::vector<cell_hit<Iter> > & hits_;
+         skip_side                      side_;
+      };
+
+      // the range cut into count chunks of about the same size, count + 1 bounds
+      template <class Iter>
+         void split_range(Iter p, Iter q, int count, std::vector<Iter> & bounds)
+      {
+         __int64 n = 0;
+         for (Iter t = p; t != q; ++t)
+            ++n;
+
+         bounds.assign(1, p);
+         __int64 pos = 0;
+         for (int c = 1; c <= count; ++c)
+         {
+            __int64 const next = n * c / count;
+            for (; pos != next; ++pos)
+               ++p;
+            bounds.push_back(p);
+         }
+      }
+   }
+
+   template <class Grid, class Iter, class Items, class Inserter>
+      void bulk_insert(Grid & grid, Iter p, Iter q, Items const & items, Inserter const & inserter)
+   {
+      using namespace bulk_insert_details;
+
+      typedef cell_hit<Iter> hit_type;
+
+      int const chunks = omp::get_max_threads();
+      int const bigs   = (int)grid.size();
+
+      std::vector<Iter> bounds;
+      split_range(p, q, chunks, bounds);
+
+      // 1. rasterization, chunk by chunk
+      std::vector<std::vector<hit_type> > hits  (chunks);
+      std::vector<std::vector<int> >      counts(chunks);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+      for (int c = 0; c < chunks; ++c)
+      {
+         hit_recorder<Grid, Iter> recorder(grid, hits[c]);
+         for (recorder.item = bounds[c]; recorder.item != bounds[c + 1]; ++recorder.item)
+            visit(grid, items.getItem(recorder.item), recorder);
+
+         counts[c].resize(bigs, 0);
+         for (size_t h = 0; h != hits[c].size(); ++h)
+            ++counts[c][hits[c][h].big];
+      }
+
+      // 2. bucketing by big cell; inside a bucket chunk 0 goes first
+      std::vector<int> bucket(bigs + 1, 0);
+      for (int b = 0, offset = 0; b != bigs; ++b)
+      {
+         bucket[b] = offset;
+         for (int c = 0; c != chunks; ++c)
+         {
+            int const count = counts[c][b];
+            counts[c][b] = offset;
+            offset += count;
+         }
+         bucket[b + 1] = offset;
+      }
+
+      std::vector<hit_type> sorted(bucket[bigs]);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+      for (int c = 0; c < chunks; ++c)
+      {
+         std::vector<int> & next = counts[c];
+         for (size_t h = 0; h != hits[c].size(); ++h)
+            sorted[next[hits[c][h].big]++] = hits[c][h];
+
+         std::vector<hit_type>().swap(hits[c]);
+      }
+
+      // 3. fill, a big cell belongs to one thread
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+      for (int b = 0; b < bigs; ++b)
+      {
+         if (bucket[b] == bucket[b + 1])
+            continue;
+
+         point_2i const big = grid.to2D(b);
+         typename Grid::bigcell_type & bigcell = grid.at(big);
+
+         for (int h = bucket[b]; h != bucket[b + 1]; ++h)
+            inserter(bigcell.at(sorted[h].small), Index2L(big, sorted[h].small), sorted[h].item);
+      }
+   }
+
+   // HitCounter::add over a range, in parallel; the counts are the same as sequential ones
+   template <class Iter, class Items>
+      void bulk_hit_count(HitCounter & counter, Iter p, Iter q, Items const & items)
+   {
+      using namespace bulk_insert_details;
+
+      int const chunks = omp::get_max_threads();
+
+      std::vector<Iter> bounds;
+      split_range(p, q, chunks, bounds);
+
+      std::vector<std::vector<int> > partial(chunks);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+      for (int c = 0; c < chunks; ++c)
+      {
+         HitCounter local(counter.tform(), counter.extents());
+         for (Iter t = bounds[c]; t != bounds[c + 1]; ++t)
+            local.add(items.getItem(t));
+
+         partial[c].assign(local.begin(), local.end());
+      }
+
+      for (int c = 0; c != chunks; ++c)
+      {
+         HitCounter::iterator it = counter.begin();
+         for (size_t i = 0; i != partial[c].size(); ++i, ++it)
+            *it += partial[c][i];
+      }
+   }
+}
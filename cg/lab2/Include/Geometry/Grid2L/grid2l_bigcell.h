@@ -8,14 +8,15 @@
 
 namespace cg 
 {
-   template <class T, class U = Empty >
-      struct grid2l_bigcell : U, array_2d_wrapper< m_ptr< array_2d<T> > >
+   // Dir - order of the small cells in memory, see extents::rowwise, tiled, morton
+   template <class T, class U = Empty, class Dir = extents::rowwise >
+      struct grid2l_bigcell : U, array_2d_wrapper< m_ptr< array_2d<T, extents::rect, Dir> > >
    {
       typedef T                    smallcell_type;
       typedef U                    header_type;
 
       typedef 
-         array_2d_wrapper< m_ptr< array_2d<T> > >
+         array_2d_wrapper< m_ptr< array_2d<T, extents::rect, Dir> > >
          array_type;
 
       U const & header() const { return *this; }
@@ -27,21 +28,21 @@ namespace cg
       void subdivide(point_2i const &subdivision)
       {
          if (subdivision.x > 0 && subdivision.y > 0)
-               set_ptr( new array_2d<T>(subdivision) );
+               set_ptr( new array_2d<T, extents::rect, Dir>(subdivision) );
       }
 
       void destroy() { reset_ptr( ); }
    };
 
-   template <class Stream, class T, class U >
-      inline void write(Stream &out, grid2l_bigcell<T, U> const & bcell)
+   template <class Stream, class T, class U, class Dir >
+      inline void write(Stream &out, grid2l_bigcell<T, U, Dir> const & bcell)
    {
       write( out, bcell.header() );
       write( out, bcell.array()  );
    }
 
-   template <class Stream, class T, class U >
-      inline void read(Stream &out, grid2l_bigcell<T, U> & bcell)
+   template <class Stream, class T, class U, class Dir >
+      inline void read(Stream &out, grid2l_bigcell<T, U, Dir> & bcell)
    {
       read( out, bcell.header() );
       read( out, bcell.array()  );
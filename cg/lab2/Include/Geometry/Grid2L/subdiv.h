@@ -1,8 +1,11 @@
 #pragma once
 
+#include <ostream>
+
 #include "Geometry\Grid1L\HitCounter.h"
 #include "Geometry\grid_params.h"
 #include "Geometry\Grid2L\Grid2L_Impl.h"
+#include "Geometry\Grid2L\bulk_insert.h"
 #include "contours\common.h"
 
 namespace cg
@@ -219,6 +222,209 @@ namespace cg
       rectangle_2 aabb_;
    };
 
+   //     Grid2L,   Grid2LAutoSubdiv  .
+   //  -    query_size (0 - ),  -    item_size.
+   //  big cell  Bx x By  N ,   kx x ky:
+   //     small cell  V = (query_size * kx / Bx + 1) * (query_size * ky / By + 1)
+   //      small cell E = N * (item_size * kx / Bx + 1) * (item_size * ky / By + 1) / (kx * ky)
+   //                 cell_cost * V + item_cost * V * E + memory_cost * kx * ky
+   // memory_cost -     ,       
+   struct grid2l_cost_model
+   {
+      grid2l_cost_model()
+         :   query_size  (0)
+         ,   cell_cost   (1)
+         ,   item_cost   (4)
+         ,   memory_cost (0.1)
+         ,   max_subdiv  (64)
+      {}
+
+      double query_size;
+      double cell_cost;
+      double item_cost;
+      double memory_cost;
+      int    max_subdiv;
+
+      double cost(point_2 const & bigcell, double item_size, int n, point_2i const & k) const
+      {
+         double const visited = (query_size * k.x / bigcell.x + 1) * (query_size * k.y / bigcell.y + 1);
+         double const items   = n * (item_size * k.x / bigcell.x + 1) * (item_size * k.y / bigcell.y + 1) / (k.x * k.y);
+
+         return cell_cost * visited + item_cost * visited * items + memory_cost * k.x * k.y;
+      }
+   };
+
+   //   Grid2LAutoSubdiv,  
+   struct grid2l_subdiv_report
+   {
+      grid2l_subdiv_report()
+         :   items(0), hits(0), item_size(0), big_cells(0), subdivided(0), small_cells(0)
+         ,   max_subdiv(0), predicted_cost(0), unsubdivided_cost(0)
+      {}
+
+      point_2i    main_extents;
+      point_2     bigcell_size;
+      int         items;
+      __int64     hits;              //   HitCounter
+      double      item_size;         //   hits / items
+      int         big_cells;
+      int         subdivided;        // big cell     
+      __int64     small_cells;
+      int         max_subdiv;        //  kx  ky
+      double      predicted_cost;    //   big cell  
+      double      unsubdivided_cost; //    ,  
+   };
+
+   inline std::ostream & operator << (std::ostream & out, grid2l_subdiv_report const & r)
+   {
+      return out
+         << "grid " << r.main_extents.x << "x" << r.main_extents.y
+         << ", big cell " << r.bigcell_size.x << "x" << r.bigcell_size.y
+         << ", items " << r.items << ", hits " << r.hits << ", item size " << r.item_size
+         << ", subdivided " << r.subdivided << "/" << r.big_cells
+         << ", small cells " << r.small_cells << ", max subdiv " << r.max_subdiv
+         << ", cost " << r.predicted_cost << " (unsubdivided " << r.unsubdivided_cost << ")";
+   }
+
+   //    big cell'  HitCounter',  grid2l_cost_model.
+   //     ,  big cell'     .
+   //  big cell'  .
+   //   Grid2LSubdiv, ,  Grid2LInitializer:
+   //
+   //    cg::Grid2LAutoSubdiv subdiv(bb);
+   //    Grid2LInitializer<Grid> grid(p, q, traits, subdiv);
+   //    log << subdiv.report();
+   struct Grid2LAutoSubdiv
+   {
+      Grid2LAutoSubdiv (rectangle_2 const & aabb, grid2l_cost_model const & model = grid2l_cost_model(),
+         int avg_items_in_bcell = 64)
+         :   aabb_ (aabb)
+         ,   model_ (model)
+         ,   avg_items_in_bcell_ (avg_items_in_bcell)
+      {}
+
+      grid_params getMainSubdiv (int n_actual) const
+      {
+         report_ = grid2l_subdiv_report();
+         report_.items = n_actual;
+
+         if (n_actual > 0 && !aabb_.empty())
+         {
+            point_2i ext = getSubdivisionParam(aabb_, avg_items_in_bcell_, n_actual);
+
+            return grid_params (aabb_.xy(), aabb_.size() / ext, ext);
+         }
+         else
+            return grid_params (point_2(0,0), point_2(1,1), point_2i(1,1));
+      }
+
+      template <class Grid, class HitCounterT >
+         void makeSubdivision (HitCounterT const & hitcounter, Grid & grid) const
+      {
+         point_2 const unit = grid.unit();
+
+         report_.main_extents = grid.extents();
+         report_.bigcell_size = unit;
+         report_.big_cells    = grid.extents().x * grid.extents().y;
+
+         for (typename HitCounterT::const_iterator it = hitcounter.begin(); it != hitcounter.end(); ++it)
+            report_.hits += *it;
+
+         report_.item_size = estimate_item_size(unit, report_.items, report_.hits);
+
+         grid.MakeSubdivision(subdivider<HitCounterT>(*this, hitcounter, unit));
+
+         if (report_.big_cells)
+         {
+            report_.predicted_cost    /= report_.big_cells;
+            report_.unsubdivided_cost /= report_.big_cells;
+         }
+      }
+
+      grid2l_subdiv_report const & report() const { return report_; }
+
+      //   big cell'  bigcell  n   item_size
+      static point_2i best_subdiv(grid2l_cost_model const & model, point_2 const & bigcell, double item_size, int n)
+      {
+         point_2i best(1, 1);
+         double   best_cost = model.cost(bigcell, item_size, n, best);
+
+         // small cell'   
+         bool const wide = bigcell.x >= bigcell.y;
+         double const aspect = wide ? bigcell.y / bigcell.x : bigcell.x / bigcell.y;
+
+         for (int k = 2; k <= model.max_subdiv; ++k)
+         {
+            int const other = max(1, (int)(k * aspect + 0.5));
+            point_2i const subdiv = wide ? point_2i(k, other) : point_2i(other, k);
+
+            double const c = model.cost(bigcell, item_size, n, subdiv);
+            if (c < best_cost)
+            {
+               best_cost = c;
+               best      = subdiv;
+            }
+         }
+
+         return best;
+      }
+
+      //   e    (e / Bx + 1) * (e / By + 1) big cell'
+      static double estimate_item_size(point_2 const & bigcell, int items, __int64 hits)
+      {
+         if (items <= 0 || hits <= items)
+            return 0;
+
+         double const r = (double)hits / items;
+         double const a = 1 / (bigcell.x * bigcell.y);
+         double const b = 1 / bigcell.x + 1 / bigcell.y;
+
+         return (-b + cg::sqrt(b * b + 4 * a * (r - 1))) / (2 * a);
+      }
+
+   private:
+      template <class HitCounterT>
+         struct subdivider
+      {
+         subdivider(Grid2LAutoSubdiv const & owner, HitCounterT const & hitcounter, point_2 const & unit)
+            :   owner_(owner), hitcounter_(hitcounter), unit_(unit)
+         {}
+
+         point_2i operator () (point_2i const & idx) const
+         {
+            grid2l_subdiv_report & r = owner_.report_;
+            int const n = hitcounter_[idx];
+
+            r.unsubdivided_cost += owner_.model_.cost(unit_, r.item_size, n, point_2i(1, 1));
+
+            if (n == 0)
+            {
+               r.predicted_cost += owner_.model_.cell_cost;
+               return point_2i(0, 0);
+            }
+
+            point_2i const subdiv = best_subdiv(owner_.model_, unit_, r.item_size, n);
+
+            r.predicted_cost += owner_.model_.cost(unit_, r.item_size, n, subdiv);
+            r.subdivided  += 1;
+            r.small_cells += subdiv.x * subdiv.y;
+            make_max(r.max_subdiv, max(subdiv.x, subdiv.y));
+
+            return subdiv;
+         }
+
+      private:
+         Grid2LAutoSubdiv const & owner_;
+         HitCounterT      const & hitcounter_;
+         point_2                  unit_;
+      };
+
+      rectangle_2                    aabb_;
+      grid2l_cost_model              model_;
+      int                            avg_items_in_bcell_;
+      mutable grid2l_subdiv_report   report_;
+   };
+
    template < class Grid, class SegmentId >
       struct SegmentInserter
          : grid2l_visitor_base<Grid, SegmentInserter< Grid, SegmentId >>
@@ -258,23 +464,29 @@ namespace cg
       //  SubdivisionParams
       //          Y getMainSubdiv   (unsigned n_actual)
       //       void makeSubdivision (HitCounter const & hitcounter, Grid & grid)
+      // getItem    , . bulk_insert
       template <class FwdIter, class Traits, class SubdivisionParams>
          Grid2LInitializer (FwdIter p, FwdIter q, Traits const & traits, SubdivisionParams const &params)
          :   Grid (params.getMainSubdiv(traits.distance(p,q)))
       {
          HitCounter hitcounter (*this);
-
-         for (FwdIter t = p; t != q; ++t)
-            hitcounter.add(traits.getItem(t));
+         bulk_hit_count(hitcounter, p, q, traits);
 
          params.makeSubdivision(hitcounter, *this);
 
-         for (FwdIter t = p; t != q; ++t)
+         //  ,  visit  SegmentInserter   
+         bulk_insert(*this, p, q, traits, segment_adder());
+      }
+
+   private:
+      struct segment_adder
+      {
+         template <class SmallCell, class FwdIter>
+            void operator () (SmallCell & scell, Index2L const &, FwdIter t) const
          {
-            SegmentInserter< Grid, FwdIter > inserter = create_segment_inserter< Grid >( t );
-            visit(*this, traits.getItem(t), inserter);
+            scell.add_segment( t );
          }
-      }
+      };
    };
 
 }
\ No newline at end of file
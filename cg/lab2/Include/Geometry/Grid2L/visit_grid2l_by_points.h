@@ -0,0 +1,163 @@
+#pragma  once
+
+#include <algorithm>
+#include <vector>
+
+#include "common\omp_utils.h"
+#include "Geometry\Grid2L\Grid2L_Impl.h"
+
+// Point queries in batches, for Grid2L and MappedGrid2L (const or not).
+//
+//    grid2l_points_batch<G> batch(grid);
+//    batch(points, count, proc, results);           // or visit_points(grid, points, count, proc, results)
+//
+// does the same as
+//
+//    for (size_t i = 0; i != count; ++i)
+//       if (point i falls into a small cell)
+//          results[i] = proc(points[i], idx, grid[idx]);
+//
+// but the points are bucketed by big cell and sorted by small cell first, so every big cell
+// is fetched once and its small cells are walked in order. results stay in input order,
+// points outside the grid or in a big cell without subdivision leave their result untouched.
+//
+// From Processor:
+//    Result operator () (point_2 const &, Index2L const &, smallcell_type &) const
+// With parallel = true the big cells are split between threads, the processor is called concurrently.
+// The batch object keeps its buffers, reuse it between frames.
+
+namespace cg
+{
+    template <class G>
+        struct grid2l_points_batch
+    {
+        typedef G                                grid_type;
+        typedef typename G::bigcell_type         bigcell_type;
+
+        explicit grid2l_points_batch(grid_type & grid)
+            : grid_(grid)
+        {}
+
+        template <class Processor, class Result>
+            void operator () (point_2 const * pts, size_t count, Processor const & proc, Result * results, bool parallel = false)
+        {
+            int const n    = (int)count;
+            int const bigs = (int)grid_.size();
+
+            // 1. indices
+            entries_.resize(n);
+#ifdef _OPENMP
+#pragma omp parallel for if (parallel)
+#endif
+            for (int i = 0; i < n; ++i)
+                entries_[i] = make_entry(pts[i], i);
+
+            // 2. bucketing by big cell, stable
+            bucket_.assign(bigs + 1, 0);
+            for (int i = 0; i != n; ++i)
+                if (entries_[i].big >= 0)
+                    ++bucket_[entries_[i].big + 1];
+
+            nonempty_.clear();
+            for (int b = 0; b != bigs; ++b)
+            {
+                if (bucket_[b + 1])
+                    nonempty_.push_back(b);
+                bucket_[b + 1] += bucket_[b];
+            }
+
+            sorted_.resize(bucket_[bigs]);
+            next_.assign(bucket_.begin(), bucket_.end() - 1);
+            for (int i = 0; i != n; ++i)
+                if (entries_[i].big >= 0)
+                    sorted_[next_[entries_[i].big]++] = entries_[i];
+
+            // 3. big cell by big cell
+            int const buckets = (int)nonempty_.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16) if (parallel)
+#endif
+            for (int k = 0; k < buckets; ++k)
+            {
+                int const b = nonempty_[k];
+                entry * p = &sorted_[bucket_[b]];
+                entry * q = p + (bucket_[b + 1] - bucket_[b]);
+
+                std::sort(p, q);
+
+                point_2i const  big     = grid_.to2D(b);
+                bigcell_type  & bigcell = grid_[big];
+
+                for (; p != q; ++p)
+                    results[p->item] = proc(pts[p->item], Index2L(big, p->small), bigcell.at(p->small));
+            }
+        }
+
+    private:
+        struct entry
+        {
+            int      big;    // linear index of the big cell, -1 if outside
+            point_2i small;
+            int      item;
+
+            // rowwise inside the big cell, then input order
+            bool operator < (entry const & other) const
+            {
+                if (small.y != other.small.y) return small.y < other.small.y;
+                if (small.x != other.small.x) return small.x < other.small.x;
+                return item < other.item;
+            }
+        };
+
+        // as visit_grid2l_by_point::calc_idx, with the small index kept inside the big cell
+        __forceinline entry make_entry(point_2 const & pt, int item) const
+        {
+            entry e;
+            e.big  = -1;
+            e.item = item;
+
+            point_2  pt_in_grid = grid_.world2local(pt);
+            point_2i idx_big    = floor(pt_in_grid);
+
+            if (!grid_.contains(idx_big))
+                return e;
+
+            bigcell_type & bigcell = grid_[idx_big];
+            if (!bigcell)
+                return e;
+
+            point_2i const ext = bigcell.extents();
+            e.small = floor((pt_in_grid - idx_big) & ext);
+
+            make_max(e.small.x, 0);
+            make_max(e.small.y, 0);
+            make_min(e.small.x, ext.x - 1);
+            make_min(e.small.y, ext.y - 1);
+
+            e.big = (int)grid_.to1D(idx_big);
+            return e;
+        }
+
+    private:
+        grid_type &         grid_;
+
+        std::vector<entry>  entries_;
+        std::vector<entry>  sorted_;
+        std::vector<int>    bucket_;
+        std::vector<int>    next_;
+        std::vector<int>    nonempty_;
+    };
+
+    template <class G, class Processor, class Result>
+        void visit_points(G & grid, point_2 const * pts, size_t count, Processor const & proc, Result * results, bool parallel = false)
+    {
+        grid2l_points_batch<G> batch(grid);
+        batch(pts, count, proc, results, parallel);
+    }
+
+    template <class T, class B, class H, class Processor, class Result>
+        void visit_points(Grid2L<T,B,H> const & grid, point_2 const * pts, size_t count, Processor const & proc, Result * results, bool parallel = false)
+    {
+        visit_points(const_cast<Grid2L<T,B,H>&>(grid), pts, count, proc, results, parallel);
+    }
+}
@@ -5,6 +5,7 @@
 #include <list>
 
 #include <boost\scoped_ptr.hpp>
+#include <boost\iterator\indirect_iterator.hpp>
 
 #include <boost\math\special_functions\next.hpp>
 
@@ -158,7 +159,8 @@ struct UIntSet
    std::vector<char>    data_;
 };
 
-template< class DCEL >
+// Predicates: cgal_predicates or adaptive_predicates (default_predicates.h)
+template< class DCEL, class Predicates = default_predicates >
    struct PSLGOverlayProcessor
 {
    ALGORITHM("PSLG Overlay")
@@ -227,6 +229,27 @@ template< class DCEL >
          , curFormationVertex_ (0)
          , checkCount_ (0)
    {
+      run(begin, end, bo_op, subdivide_input, debug);
+   }
+
+   // Processor for several overlays in turn, each run() writes to res.
+   // The containers keep their memory between runs (see cg::pslg::overlay_batch())
+   explicit PSLGOverlayProcessor ( DCEL &res )
+      : dcelRes_ (res)
+      , boOp_ (BO_UNION)
+      , dcelAmount_ (0)
+      , sweepFinished_ (false)
+      , curFormationVertex_ (0)
+      , checkCount_ (0)
+   {
+   }
+
+   template< class FwdDCELIter >
+      void run( FwdDCELIter begin, FwdDCELIter end, BooleanOp bo_op,
+                bool subdivide_input = false, bool debug = false )
+   {
+      reset(bo_op);
+
       try
       {
          PerfCounter pf;
@@ -234,8 +257,11 @@ template< class DCEL >
          if (begin != end)
             combineDCELs(begin, end, subdivide_input);
 
+#ifdef DEBUG_POLYOPS
+         // not thread safe, overlays may run in parallel (pslg_overlay_parallel.h)
          static double t_comb = 0;
          t_comb += pf.time(); pf.restart();
+#endif
 
          subStatus_.resize(dcelAmount_);
          setStart_.resize(dcelAmount_);
@@ -249,8 +275,10 @@ template< class DCEL >
          //   deleteEdge(edgesToDelete_[i]);
          destroyIsolatedVertices();
 
+#ifdef DEBUG_POLYOPS
          static double t_prep = 0;
          t_prep += pf.time(); pf.restart();
+#endif
          // fixDanglingVertices();
 
          // Prepare DCEL for sweep line processing
@@ -266,10 +294,10 @@ template< class DCEL >
 
             destroyIsolatedVertices();
 
+#ifdef DEBUG_POLYOPS
             static double t_sweep = 0;
             t_sweep += pf.time(); 
 
-#ifdef DEBUG_POLYOPS
             std::ofstream("d://pslg.log") 
                << "combine = " << t_comb 
                << " prep = " << t_prep
@@ -340,12 +368,41 @@ template< class DCEL >
    };
 
    typedef
-      cg::robust_segments_intersector< cg::segment_2, std::vector<cg::segment_2>, EdgeFilter >
+      cg::robust_segments_intersector< cg::segment_2, std::vector<cg::segment_2>, EdgeFilter, Predicates >
       intersector_type;
 
    boost::scoped_ptr< intersector_type > intersector;
 
 private:
+   // state left by the previous run
+   void reset( BooleanOp bo_op )
+   {
+      boOp_ = bo_op;
+      dcelAmount_ = 0;
+      sweepFinished_ = false;
+      curFormationVertex_ = 0;
+      checkCount_ = 0;
+
+      while (!queue_.empty())
+         queue_.pop();
+      while (!edges2Handle_.empty())
+         edges2Handle_.pop();
+
+      status_.clear();
+      subStatus_.clear();
+      iteratedEdges_.clear();
+      nextCycle_.clear();
+
+      edgeInfo_.clear();
+      setStart_.clear();
+      setStartEx_.clear();
+      setIn_.clear();
+      setInInitialized_.clear();
+      setInH_.clear();
+      setInG_.clear();
+      setStartH_.clear();
+   }
+
    template< class FwdDCELIter, class intersector_type, class correspondence_map_type >
    void subdivide_edge( FwdDCELIter begin, FwdDCELIter end, bool subdivide_input,
                         std::pair< size_t, bool > edgeHolderIdx, size_t edge2subdiv,
@@ -404,6 +461,7 @@ private:
          std::map< size_t, std::pair< size_t, size_t > >
          correspondence_map;
 
+      // needed only to subdivide the inputs
       correspondence_map corr;
       dcelAmount_ = edgesContainerSize.size();
       for (DCEL::edges_const_iterator eIt = dcelRes_.edgesBegin(); eIt != dcelRes_.edgesEnd(); ++eIt)
@@ -416,47 +474,50 @@ private:
          if (*edgeEqRange.first == eIt.index())
             dcelIdx++;
 
-         size_t input_idx = eIt.index();
-         if (dcelIdx != 0)
-            input_idx -= edgesContainerSize[dcelIdx - 1];
-         corr[eIt.index()] = std::make_pair(dcelIdx, input_idx);
+         if (subdivide_input)
+         {
+            size_t input_idx = eIt.index();
+            if (dcelIdx != 0)
+               input_idx -= edgesContainerSize[dcelIdx - 1];
+            corr[eIt.index()] = std::make_pair(dcelIdx, input_idx);
+         }
 
          edgeInfo(eIt.index()) = EdgeInfo (!eIt->hole ? ET_DCEL : ET_UNDEF, dcelIdx);
       }
 
       // Process intersections
-      std::vector< cg::segment_2 > edge_segments;
-      edge_segments.reserve(dcelRes_.edgesSize());
-      std::map< size_t, size_t > idx_converter;
+      // segment index -> edge index
+      edgeSegments_.clear();
+      edgeSegments_.reserve(dcelRes_.edgesSize());
+      segmentEdge_.clear();
       for (DCEL::edges_iterator eIt = dcelRes_.edgesBegin(); eIt != dcelRes_.edgesEnd(); ++eIt)
       {
          if (eIt->hole)
             continue;
 
-         idx_converter[edge_segments.size()] = eIt.index();
-         edge_segments.push_back(cg::segment_2 (dcelRes_.vertex(eIt->vertexOrigin).pos,
+         segmentEdge_.push_back(eIt.index());
+         edgeSegments_.push_back(cg::segment_2 (dcelRes_.vertex(eIt->vertexOrigin).pos,
             dcelRes_.vertex(eIt->vertexDestination).pos));
       }
 
       EdgeFilter edge_filter(boOp_, dcelRes_);
 
-      intersector.reset(new intersector_type (edge_segments, false, 1e-10, edge_filter));
+      intersector.reset(new intersector_type (edgeSegments_, false, 1e-10, edge_filter));
 
-      typedef
-         std::set< size_t >
-         intersection_map;
-         
-      intersection_map subdivision;
+      // segments to subdivide, ascending
+      subdivision_.clear();
       for (size_t i = 0; i < intersector->size(); ++i)
       {
-         subdivision.insert((*intersector)[i].idA());
-         subdivision.insert((*intersector)[i].idB());
+         subdivision_.push_back((*intersector)[i].idA());
+         subdivision_.push_back((*intersector)[i].idB());
       }
+      std::sort(subdivision_.begin(), subdivision_.end());
+      subdivision_.erase(std::unique(subdivision_.begin(), subdivision_.end()), subdivision_.end());
 
-      for (intersection_map::iterator it = subdivision.begin(); it != subdivision.end(); ++it)
+      for (std::vector< size_t >::const_iterator it = subdivision_.begin(); it != subdivision_.end(); ++it)
       {
          subdivide_edge(begin, end, subdivide_input,
-            intersector->input2holder(*it), idx_converter[*it], *intersector, corr);
+            intersector->input2holder(*it), segmentEdge_[*it], *intersector, corr);
       }
    }
 
@@ -527,7 +588,7 @@ public:
       };
    };
 
-   typedef std::multiset< StateEdge, pslg::SegmentXLess< StateEdge > > SweepState;
+   typedef std::multiset< StateEdge, pslg::SegmentXLess< StateEdge, Predicates > > SweepState;
 
    enum EdgeType
    {
@@ -674,7 +735,7 @@ private:
             size_t curEdge = curEdges.front();
 
             size_t prevEdge = dcelRes_.findEdgeNextToLine(dcelRes_.edge(curEdge).vertexDestination,
-               eventIdx, DCEL::RobustOrientationPredicate (), false);
+               eventIdx, typename DCEL::template PolicyOrientationPredicate< Predicates > (), false);
             Verify(prevEdge != -1);
 
             // Correct place in case of intersection by border
@@ -1036,7 +1097,7 @@ private:
                size_t curEdge = edgesToAdd[i];
 
                size_t prevEdge = dcelRes_.findEdgeNextToLine(dcelRes_.edge(curEdge).vertexDestination,
-                  eventVertices[place->second], DCEL::RobustOrientationPredicate (), false);
+                  eventVertices[place->second], typename DCEL::template PolicyOrientationPredicate< Predicates > (), false);
                Verify(prevEdge != -1);
 
                if (cg::dcel::areEdgesEqual(dcelRes_, prevEdge, curEdge))
@@ -1519,7 +1580,7 @@ private:
             ++edgeIt;
             
             cg::segment_2 es = cg::dcel::edgeSegment(dcelRes_, *edgeIt);
-            VecOrientation orien = robust_orientation(es.P1(), es.P0(), prevEs.P1());
+            VecOrientation orien = Predicates::orientation(es.P1(), es.P0(), prevEs.P1());
             if (orien == VO_RIGHT)
                leapIt = edgeIt;
          }
@@ -1792,6 +1853,11 @@ private:
    size_t checkCount_;
    static size_t const MaxCheckCount = 16;
 
+   // Input subdivision
+   std::vector< cg::segment_2 > edgeSegments_;
+   std::vector< size_t > segmentEdge_;
+   std::vector< size_t > subdivision_;
+
    // Algorithm data
    std::vector< EdgeInfo > edgeInfo_;
    std::vector< typename StateEdge::Membership > setStart_;
@@ -1817,9 +1883,18 @@ template< class FwdDCELIter >
 template< class DCEL >
    void overlay( DCEL &res, DCEL const &a, DCEL const &b, BooleanOp bo_op )
 {
-   std::vector< DCEL > input (2);
-   input[0] = a, input[1] = b;
-   overlay(res, input.begin(), input.end(), bo_op);
+   // the result is built over the first input, so one that is also the result goes as a copy
+   if (&res == &a || &res == &b)
+   {
+      std::vector< DCEL > input (2);
+      input[0] = a, input[1] = b;
+      overlay(res, input.begin(), input.end(), bo_op);
+      return;
+   }
+
+   DCEL * input[2] = { const_cast< DCEL * >(&a), const_cast< DCEL * >(&b) };
+   PSLGOverlayProcessor< DCEL > (res,
+      boost::make_indirect_iterator(input), boost::make_indirect_iterator(input + 2), bo_op, false);
 }
 
 template< class DCEL, class FwdDCELIter >
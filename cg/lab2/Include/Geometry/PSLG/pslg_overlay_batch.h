@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+
+#include <boost\iterator\indirect_iterator.hpp>
+
+#include "pslg_overlay.h"
+
+// Many independent overlays of two DCELs each, e.g. parcels clipped by tile masks.
+//
+//    std::vector< cg::pslg::overlay_job< DCEL > > jobs;
+//    jobs.push_back(cg::pslg::overlay_job< DCEL >(parcel, mask, cg::BO_INTERSECTION));
+//    ...
+//    std::vector< DCEL > res (jobs.size());
+//    cg::pslg::overlay_batch(&jobs[0], jobs.size(), &res[0]);
+//
+// gives res[i] == cg::pslg::overlay(res[i], *jobs[i].a, *jobs[i].b, jobs[i].op).
+// The inputs are used in place, not copied, so res must not hold any of them while the batch
+// runs. Every thread has its own PSLGOverlayProcessor
+// and result DCEL, created once and reused for all its jobs, so small overlays don't pay
+// for allocating the processor containers each time.
+// A job that throws is repeated serially after the others are done, so the exception
+// comes out as from cg::pslg::overlay().
+
+namespace cg
+{
+namespace pslg
+{
+
+template< class DCEL >
+   struct overlay_job
+{
+   overlay_job()
+      : a (NULL), b (NULL), op (BO_UNION)
+   {}
+
+   overlay_job( DCEL const &a, DCEL const &b, BooleanOp op )
+      : a (&a), b (&b), op (op)
+   {}
+
+   DCEL const * a;
+   DCEL const * b;
+   BooleanOp    op;
+};
+
+template< class DCEL >
+   void overlay_batch( overlay_job< DCEL > const * jobs, size_t count, DCEL * res, bool parallel = true )
+{
+   int const n = (int)count;
+   std::vector< char > failed (count, 0);
+
+#ifdef _OPENMP
+#pragma omp parallel if (parallel && n > 1)
+#endif
+   {
+      DCEL scratch;
+      PSLGOverlayProcessor< DCEL > processor (scratch);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+      for (int i = 0; i < n; ++i)
+      {
+         // the result goes to scratch, res[i] is only assigned
+         DCEL * input[2] = { const_cast< DCEL * >(jobs[i].a), const_cast< DCEL * >(jobs[i].b) };
+
+         try
+         {
+            processor.run(boost::make_indirect_iterator(input), boost::make_indirect_iterator(input + 2), jobs[i].op);
+            res[i] = scratch;
+         }
+         catch (...)
+         {
+            failed[i] = 1;
+         }
+      }
+   }
+
+   for (size_t i = 0; i != count; ++i)
+      if (failed[i])
+         overlay(res[i], *jobs[i].a, *jobs[i].b, jobs[i].op);
+}
+
+template< class DCEL >
+   void overlay_batch( std::vector< overlay_job< DCEL > > const &jobs, std::vector< DCEL > &res, bool parallel = true )
+{
+   res.resize(jobs.size());
+   if (!jobs.empty())
+      overlay_batch(&jobs[0], jobs.size(), &res[0], parallel);
+}
+
+} // End of 'pslg' namespace
+} // End of 'cg' namespace
@@ -0,0 +1,539 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "common\omp_utils.h"
+
+#include "pslg_overlay.h"
+
+// Parallel mode of the PSLG overlay, for inputs with a lot of vertices.
+//
+//    cg::pslg::overlay_parallel(res, begin, end, bo_op);
+//
+// gives the same cycles as cg::pslg::overlay(res, begin, end, bo_op):
+//  1. the bounding box is cut by horizontal lines into strips, the lines go between vertex heights.
+//     Every input edge crossing a line gets a vertex on it, computed once for all the strips;
+//  2. each strip clips the input cycles by a walk along them, there is a vertex wherever a cycle
+//     meets a line, and runs one overlay of the clipped inputs with the usual PSLGOverlayProcessor,
+//     strips go in parallel;
+//  3. the strip results are glued: the pieces of the lines come in pairs of opposite edges and are
+//     dropped, the rest is chained back into cycles and the vertices added in 1 are removed.
+//
+// Edge data of the inputs is not carried to the result.
+// BO_IGNORE, a single strip, an exception in any strip, an input with overlapping cycles, which
+// the clipping can't close, or strips that split a line differently fall back to the serial overlay.
+
+namespace cg
+{
+namespace pslg
+{
+
+namespace overlay_parallel_details
+{
+   typedef std::vector< cg::point_2 >  contour_type;
+   typedef std::vector< contour_type > contours_type;
+
+   struct input_cycles
+   {
+      contours_type                          cycles;
+      std::vector< std::pair<double, double> > yrange;
+      bool                                   ccw;    // the region is on the left of the cycles
+   };
+
+   struct stitch_edge
+   {
+      cg::point_2 a, b;
+      size_t      next;  // in the same strip cycle
+      bool        used;
+   };
+
+   // lines strictly between distinct vertex heights, about the same number of heights in every strip
+   inline void choose_cuts( std::vector< double > & ys, size_t strips, std::vector< double > & cuts )
+   {
+      std::sort(ys.begin(), ys.end());
+      ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+      for (size_t k = 1; k < strips; ++k)
+      {
+         size_t const i = ys.size() * k / strips;
+         if (i == 0 || i >= ys.size())
+            continue;
+
+         double const y = (ys[i - 1] + ys[i]) / 2;
+         if (ys[i - 1] < y && y < ys[i] && (cuts.empty() || cuts.back() < y))
+            cuts.push_back(y);
+      }
+   }
+
+   // point of the edge at height y, the same whichever way the edge goes
+   inline cg::point_2 cut_point( cg::point_2 a, cg::point_2 b, double y )
+   {
+      if (b < a)
+         std::swap(a, b);
+
+      return cg::point_2 (a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y), y);
+   }
+
+   inline void split_by_cuts( contours_type & cycles, std::vector< double > const & cuts, std::set< cg::point_2 > & added )
+   {
+      typedef std::vector< double >::const_iterator cut_iterator;
+
+      for (size_t c = 0; c != cycles.size(); ++c)
+      {
+         contour_type const & src = cycles[c];
+         contour_type         dst;
+
+         for (size_t i = 0; i != src.size(); ++i)
+         {
+            cg::point_2 const & p = src[i];
+            cg::point_2 const & q = src[(i + 1) % src.size()];
+
+            dst.push_back(p);
+
+            if (p.y < q.y)
+            {
+               cut_iterator lo = std::upper_bound(cuts.begin(), cuts.end(), p.y);
+               cut_iterator hi = std::lower_bound(cuts.begin(), cuts.end(), q.y);
+               for (cut_iterator it = lo; it != hi; ++it)
+                  dst.push_back(*added.insert(cut_point(p, q, *it)).first);
+            }
+            else if (q.y < p.y)
+            {
+               cut_iterator lo = std::upper_bound(cuts.begin(), cuts.end(), q.y);
+               cut_iterator hi = std::lower_bound(cuts.begin(), cuts.end(), p.y);
+               for (cut_iterator it = hi; it != lo; --it)
+                  dst.push_back(*added.insert(cut_point(p, q, *(it - 1))).first);
+            }
+         }
+
+         cycles[c].swap(dst);
+      }
+   }
+
+   struct clip_event
+   {
+      double x;      // along the line, in the direction the boundary of the clipped region goes
+      bool   entry;  // chain starts here
+      size_t chain;
+
+      bool operator < ( clip_event const & other ) const
+      {
+         if (x != other.x)
+            return x < other.x;
+         return entry && !other.entry;
+      }
+   };
+
+   // chains ending on a line are joined to chains starting on it, going along the line with the
+   // region on the left; false if the line pieces don't alternate, as with overlapping cycles
+   inline bool pair_on_line( std::vector< clip_event > & events, std::vector< size_t > & next )
+   {
+      std::sort(events.begin(), events.end());
+
+      size_t const none    = static_cast< size_t >( -1 );
+      size_t       pending = none;
+
+      for (size_t i = 0; i != events.size(); ++i)
+      {
+         clip_event const & ev = events[i];
+         if (ev.entry == (pending == none))
+            return false;
+
+         if (ev.entry)
+            next[pending] = ev.chain, pending = none;
+         else
+            pending = ev.chain;
+      }
+
+      return pending == none;
+   }
+
+   // cycles of one input clipped by the strip between two lines. After split_by_cuts no edge crosses
+   // a line, so the parts inside are chains from line to line and the walk needs no intersections;
+   // the chains are closed along the lines
+   inline bool clip_by_strip( input_cycles const & input, double ylo, double yhi, contours_type & res )
+   {
+      contours_type const &                            cycles = input.cycles;
+      std::vector< std::pair<double, double> > const & yrange = input.yrange;
+
+      contours_type chains;
+      for (size_t c = 0; c != cycles.size(); ++c)
+      {
+         contour_type const & src = cycles[c];
+         size_t const n = src.size();
+         if (yrange[c].second <= ylo || yrange[c].first >= yhi || n < 3)
+            continue;
+
+         // edges with the inside of the strip on one side, those on the lines and outside are dropped
+         std::vector< bool > inside (n);
+         size_t count = 0, first = n;
+         for (size_t i = 0; i != n; ++i)
+         {
+            cg::point_2 const & p = src[i];
+            cg::point_2 const & q = src[(i + 1) % n];
+
+            inside[i] = std::min(p.y, q.y) >= ylo && std::max(p.y, q.y) <= yhi && !(p.y == q.y && (p.y == ylo || p.y == yhi));
+            count += inside[i];
+         }
+
+         if (count == n)
+         {
+            res.push_back(src);
+            continue;
+         }
+
+         for (size_t i = 0; i != n && first == n; ++i)
+            if (inside[i] && !inside[(i + n - 1) % n])
+               first = i;
+
+         for (size_t k = 0; k != n && first != n; ++k)
+         {
+            size_t const i = (first + k) % n;
+            if (!inside[i])
+               continue;
+
+            if (!inside[(i + n - 1) % n])
+               chains.push_back(contour_type (1, src[i]));
+            chains.back().push_back(src[(i + 1) % n]);
+         }
+      }
+
+      if (chains.empty())
+         return true;
+
+      // bottom line is gone in +x with the region on the left, the top one in -x
+      double const dir = input.ccw ? 1 : -1;
+
+      std::vector< clip_event > lo, hi;
+      for (size_t i = 0; i != chains.size(); ++i)
+      {
+         cg::point_2 const ends[] = { chains[i].front(), chains[i].back() };
+         for (int e = 0; e != 2; ++e)
+         {
+            clip_event ev;
+            ev.entry = e == 0;
+            ev.chain = i;
+
+            if (ends[e].y == ylo)
+               ev.x = dir * ends[e].x, lo.push_back(ev);
+            else if (ends[e].y == yhi)
+               ev.x = -dir * ends[e].x, hi.push_back(ev);
+            else
+               return false;
+         }
+      }
+
+      std::vector< size_t > next (chains.size());
+      if (!pair_on_line(lo, next) || !pair_on_line(hi, next))
+         return false;
+
+      std::vector< bool > used (chains.size());
+      for (size_t i = 0; i != chains.size(); ++i)
+      {
+         if (used[i])
+            continue;
+
+         contour_type cycle;
+         for (size_t j = i; !used[j]; j = next[j])
+         {
+            used[j] = true;
+            for (size_t v = 0; v != chains[j].size(); ++v)
+               if (cycle.empty() || !(cycle.back() == chains[j][v]))
+                  cycle.push_back(chains[j][v]);
+         }
+
+         if (cycle.size() > 1 && cycle.front() == cycle.back())
+            cycle.pop_back();
+
+         res.push_back(cycle);
+      }
+
+      return true;
+   }
+
+   // overlay of the input cycles clipped by the strip between ylo and yhi, false if the clipping
+   // failed and the strip has to be done the serial way
+   template< class DCEL >
+      bool overlay_strip( std::vector< input_cycles > const & inputs, double ylo, double yhi,
+                          BooleanOp bo_op, contours_type & res )
+   {
+      std::vector< DCEL > clipped;
+      clipped.reserve(inputs.size());
+
+      for (size_t i = 0; i != inputs.size(); ++i)
+      {
+         contours_type part;
+         if (!clip_by_strip(inputs[i], ylo, yhi, part))
+            return false;
+
+         clipped.push_back(DCEL ());
+         bool const non_empty = cg::dcel::convertContourToDCEL(clipped.back(), part);
+         if (!non_empty)
+            clipped.pop_back();
+
+         // an empty input empties the whole strip or changes nothing
+         if (!non_empty && (bo_op == BO_INTERSECTION || (bo_op == BO_DIFFERENCE && i == 0)))
+            return true;
+      }
+
+      if (clipped.empty())
+         return true;
+
+      DCEL strip_res;
+      overlay(strip_res, clipped.begin(), clipped.end(), bo_op);
+      cg::dcel::convertDCELToContour(res, strip_res);
+      return true;
+   }
+
+   // clockwise angle from direction 'from' to direction 'to', in (0, 2 pi]
+   inline double clockwise_angle( cg::point_2 const & from, cg::point_2 const & to )
+   {
+      double const two_pi = 2 * 3.14159265358979323846;
+      double a = std::atan2(from.y, from.x) - std::atan2(to.y, to.x);
+      while (a <= 0)
+         a += two_pi;
+      while (a > two_pi)
+         a -= two_pi;
+      return a;
+   }
+
+   // false if the strips don't agree on the pieces of some line, e.g. an intersection rounded onto
+   // the line in one strip only
+   inline bool stitch( std::vector< contours_type > const & strips, std::vector< double > const & cuts,
+                       std::set< cg::point_2 > const & added, contours_type & res )
+   {
+      // 1. all strip edges
+      std::vector< stitch_edge > edges;
+      for (size_t s = 0; s != strips.size(); ++s)
+         for (size_t c = 0; c != strips[s].size(); ++c)
+         {
+            contour_type const & cycle = strips[s][c];
+            size_t const base = edges.size();
+
+            for (size_t i = 0; i != cycle.size(); ++i)
+            {
+               stitch_edge e;
+               e.a    = cycle[i];
+               e.b    = cycle[(i + 1) % cycle.size()];
+               e.next = base + (i + 1) % cycle.size();
+               e.used = false;
+               edges.push_back(e);
+            }
+         }
+
+      // 2. opposite pieces of the lines cancel each other
+      typedef std::map< std::pair< cg::point_2, cg::point_2 >, std::vector< size_t > > open_edges;
+      open_edges open;
+
+      for (size_t e = 0; e != edges.size(); ++e)
+      {
+         stitch_edge const & edge = edges[e];
+         if (edge.a.y != edge.b.y || !std::binary_search(cuts.begin(), cuts.end(), edge.a.y))
+            continue;
+
+         open_edges::iterator twin = open.find(std::make_pair(edge.b, edge.a));
+         if (twin != open.end() && !twin->second.empty())
+         {
+            edges[e].used = edges[twin->second.back()].used = true;
+            twin->second.pop_back();
+         }
+         else
+            open[std::make_pair(edge.a, edge.b)].push_back(e);
+      }
+
+      for (open_edges::const_iterator it = open.begin(); it != open.end(); ++it)
+         if (!it->second.empty())
+            return false;
+
+      typedef std::multimap< cg::point_2, size_t > outgoing_edges;
+      outgoing_edges outgoing;
+      for (size_t e = 0; e != edges.size(); ++e)
+         if (!edges[e].used)
+            outgoing.insert(std::make_pair(edges[e].a, e));
+
+      // 3. cycles: the strip order where it is left, otherwise the first edge clockwise
+      //    from the incoming one, so the face on the left stays on the left
+      for (size_t start = 0; start != edges.size(); ++start)
+      {
+         if (edges[start].used)
+            continue;
+
+         contour_type cycle;
+         for (size_t e = start; ; )
+         {
+            edges[e].used = true;
+            cycle.push_back(edges[e].a);
+
+            size_t next = edges[e].next;
+            if (next != start && edges[next].used)
+            {
+               cg::point_2 const back = edges[e].a - edges[e].b;
+
+               next = static_cast< size_t >( -1 );
+               double best = 0;
+
+               std::pair< outgoing_edges::iterator, outgoing_edges::iterator > range = outgoing.equal_range(edges[e].b);
+               for (outgoing_edges::iterator it = range.first; it != range.second; ++it)
+               {
+                  if (edges[it->second].used && it->second != start)
+                     continue;
+
+                  double const angle = clockwise_angle(back, edges[it->second].b - edges[it->second].a);
+                  if (next == static_cast< size_t >( -1 ) || angle < best)
+                     next = it->second, best = angle;
+               }
+            }
+
+            if (next == start || next == static_cast< size_t >( -1 ))
+               break;
+
+            e = next;
+         }
+
+         // 4. vertices on the lines that were added in split_by_cuts
+         contour_type dst;
+         for (size_t i = 0; i != cycle.size(); ++i)
+         {
+            cg::point_2 const & p    = cycle[i];
+            cg::point_2 const & prev = cycle[(i + cycle.size() - 1) % cycle.size()];
+            cg::point_2 const & next = cycle[(i + 1) % cycle.size()];
+
+            if (added.count(p) && (prev.y - p.y) * (next.y - p.y) < 0)
+               continue;
+
+            dst.push_back(p);
+         }
+
+         if (dst.size() >= 3)
+            res.push_back(dst);
+      }
+
+      return true;
+   }
+}
+
+template< class FwdDCELIter >
+   void overlay_parallel( typename FwdDCELIter::value_type & res, FwdDCELIter begin, FwdDCELIter end, BooleanOp bo_op,
+                          size_t strips = 0 )
+{
+   using namespace overlay_parallel_details;
+
+   typedef typename FwdDCELIter::value_type DCEL;
+
+   if (strips == 0)
+      strips = 2 * omp::get_max_threads();
+
+   if (bo_op == BO_IGNORE || strips < 2 || begin == end)
+   {
+      overlay(res, begin, end, bo_op);
+      return;
+   }
+
+   // 1. cycles of the inputs and the lines
+   std::vector< input_cycles > inputs;
+   std::vector< double >       ys;
+   cg::rectangle_2             bound;
+
+   for (FwdDCELIter it = begin; it != end; ++it)
+   {
+      inputs.push_back(input_cycles ());
+      cg::dcel::convertDCELToContour(inputs.back().cycles, *it);
+
+      contours_type const & cycles = inputs.back().cycles;
+      double area = 0;
+      for (size_t c = 0; c != cycles.size(); ++c)
+         for (size_t i = 0; i != cycles[c].size(); ++i)
+         {
+            ys.push_back(cycles[c][i].y);
+            bound |= cycles[c][i];
+            area += cycles[c][i] ^ cycles[c][(i + 1) % cycles[c].size()];
+         }
+      inputs.back().ccw = area >= 0;
+   }
+
+   std::vector< double > cuts;
+   choose_cuts(ys, strips, cuts);
+
+   if (cuts.empty())
+   {
+      overlay(res, begin, end, bo_op);
+      return;
+   }
+
+   std::set< cg::point_2 > added;
+   for (size_t i = 0; i != inputs.size(); ++i)
+   {
+      split_by_cuts(inputs[i].cycles, cuts, added);
+
+      contours_type const & cycles = inputs[i].cycles;
+      inputs[i].yrange.resize(cycles.size());
+      for (size_t c = 0; c != cycles.size(); ++c)
+      {
+         std::pair< double, double > & r = inputs[i].yrange[c];
+         r.first = r.second = cycles[c].empty() ? 0 : cycles[c][0].y;
+         for (size_t v = 0; v != cycles[c].size(); ++v)
+         {
+            r.first  = std::min(r.first,  cycles[c][v].y);
+            r.second = std::max(r.second, cycles[c][v].y);
+         }
+      }
+   }
+
+   // 2. strips
+   double const margin = 1 + bound.y.size();
+
+   int const count = (int)cuts.size() + 1;
+   std::vector< contours_type > parts (count);
+   bool failed = false;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+   for (int k = 0; k < count; ++k)
+   {
+      double const ylo = k == 0             ? bound.y.lo() - margin : cuts[k - 1];
+      double const yhi = k == count - 1     ? bound.y.hi() + margin : cuts[k];
+
+      bool done = false;
+      try
+      {
+         done = overlay_strip< DCEL >(inputs, ylo, yhi, bo_op, parts[k]);
+      }
+      catch (...)
+      {
+      }
+
+      if (!done)
+      {
+#ifdef _OPENMP
+#pragma omp critical (overlay_parallel_failed)
+#endif
+         failed = true;
+      }
+   }
+
+   if (failed)
+   {
+      overlay(res, begin, end, bo_op);
+      return;
+   }
+
+   // 3. glueing
+   contours_type cycles;
+   if (!stitch(parts, cuts, added, cycles))
+   {
+      overlay(res, begin, end, bo_op);
+      return;
+   }
+
+   DCEL out;
+   cg::dcel::convertContourToDCEL(out, cycles);
+   res = out;
+}
+
+} // End of 'pslg' namespace
+} // End of 'cg' namespace
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Geometry\default_predicates.h"
+
 //
 // Predicate to compare two segments by x coordinate
 // Point-segment is mentioned to be greater if lies on not point-segment
@@ -10,7 +12,7 @@ namespace cg
 namespace pslg
 {
 
-template< class Segment >
+template< class Segment, class Predicates = default_predicates >
    struct SegmentXLess
 {
    typedef typename Segment::point_type point_type;
@@ -64,7 +66,7 @@ template< class Segment >
          if (isBPointEdge || isAPointEdge || (isAHorizontal && isBHorizontal))
             return false;
 
-         return robust_left_turn_strict(b.vertexOrigin, b.vertexDestination, a.vertexOrigin);
+         return Predicates::left_turn_strict(b.vertexOrigin, b.vertexDestination, a.vertexOrigin);
       }
 
       if (a.vertexDestination.y >= b.vertexDestination.y)
@@ -78,11 +80,11 @@ template< class Segment >
          }
 
          VecOrientation orien = b.vertexDestination != a.vertexOrigin ?
-            robust_orientation(b.vertexDestination, a.vertexOrigin, a.vertexDestination) :
-            robust_orientation(a.vertexDestination, a.vertexOrigin, b.vertexOrigin);
+            Predicates::orientation(b.vertexDestination, a.vertexOrigin, a.vertexDestination) :
+            Predicates::orientation(a.vertexDestination, a.vertexOrigin, b.vertexOrigin);
 
          if (orien == VO_COLLINEAR)
-            return robust_orientation(b.vertexOrigin, a.vertexOrigin, a.vertexDestination) == VO_RIGHT;
+            return Predicates::orientation(b.vertexOrigin, a.vertexOrigin, a.vertexDestination) == VO_RIGHT;
 
          return orien == VO_RIGHT;
       }
@@ -98,11 +100,11 @@ template< class Segment >
          }
 
          VecOrientation orien = a.vertexDestination != b.vertexOrigin ?
-            robust_orientation(a.vertexDestination, b.vertexOrigin, b.vertexDestination) :
-            robust_orientation(b.vertexDestination, b.vertexOrigin, a.vertexOrigin);
+            Predicates::orientation(a.vertexDestination, b.vertexOrigin, b.vertexDestination) :
+            Predicates::orientation(b.vertexDestination, b.vertexOrigin, a.vertexOrigin);
 
          if (orien == VO_COLLINEAR)
-            return robust_orientation(a.vertexOrigin, b.vertexOrigin, b.vertexDestination) == VO_LEFT;
+            return Predicates::orientation(a.vertexOrigin, b.vertexOrigin, b.vertexDestination) == VO_LEFT;
 
          return orien == VO_LEFT;
       }
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <queue>
 #include <list>
+#include <vector>
 
 #include "Impl\SkeletonGrid\Geometry\beam.h"
 
@@ -164,24 +167,261 @@ namespace ss
       }
    };
 
-   typedef std::multiset< EventData, EventPriorityLess > EventQueueBase;
-
-   struct EventQueue : public EventQueueBase
+   // Indexed 4-ary heap of events. The events are kept in a pool of slots reused after pop/erase,
+   // the heap holds the keys and the slot numbers. An iterator is a slot, it stays valid until
+   // its event is popped or erased, so a vertex keeps it to change or remove its event in place.
+   // begin() is the top, the rest goes in heap order. Of equal events the last pushed comes first.
+   class EventQueue
    {
+      struct Slot
+      {
+         EventData event;
+         size_t pos; // in heap_, npos if free
+      };
+
+      struct HeapEntry
+      {
+         double t;
+         EventType type;
+         size_t stamp;
+         size_t slot;
+      };
+
+      static size_t const npos = static_cast< size_t >( -1 );
+      static size_t const arity = 4;
+
+   public:
+      class iterator
+      {
+      public:
+         typedef std::forward_iterator_tag iterator_category;
+         typedef EventData                 value_type;
+         typedef ptrdiff_t                 difference_type;
+         typedef EventData const *         pointer;
+         typedef EventData const &         reference;
+
+         iterator ()
+            : queue_ (NULL)
+            , slot_ (npos)
+         {
+         }
+
+         EventData const &operator * () const { return queue_->slots_[slot_].event; }
+         EventData const *operator -> () const { return &queue_->slots_[slot_].event; }
+
+         iterator &operator ++ ()
+         {
+            size_t const next = queue_->slots_[slot_].pos + 1;
+            if (next < queue_->heap_.size())
+               slot_ = queue_->heap_[next].slot;
+            else
+               slot_ = npos;
+            return *this;
+         }
+
+         iterator operator ++ ( int )
+         {
+            iterator res = *this;
+            ++*this;
+            return res;
+         }
+
+         bool operator == ( iterator const &other ) const { return slot_ == other.slot_; }
+         bool operator != ( iterator const &other ) const { return slot_ != other.slot_; }
+
+      private:
+         friend class EventQueue;
+
+         iterator ( EventQueue const *queue, size_t slot )
+            : queue_ (queue)
+            , slot_ (slot)
+         {
+         }
+
+         EventQueue const *queue_;
+         size_t slot_;
+      };
+
+      typedef iterator const_iterator;
+
+      EventQueue ()
+         : stamp_ (0)
+      {
+      }
+
       iterator push( EventData const &event )
       {
-         return insert(begin(), event);
+         size_t slot;
+         if (freeSlots_.empty())
+         {
+            slot = slots_.size();
+            slots_.push_back(Slot ());
+         }
+         else
+         {
+            slot = freeSlots_.back();
+            freeSlots_.pop_back();
+         }
+
+         slots_[slot].event = event;
+         heap_.push_back(makeEntry(event, slot));
+         siftUp(heap_.size() - 1);
+         return iterator (this, slot);
       }
-      
+
       void pop()
       {
-         erase(begin());
+         removeAt(0);
+      }
+
+      EventData const &top() const
+      {
+         return slots_[heap_.front().slot].event;
+      }
+
+      void erase( iterator it )
+      {
+         removeAt(slots_[it.slot_].pos);
+      }
+
+      // Replaces the event, the iterator stays valid
+      void update( iterator it, EventData const &event )
+      {
+         slots_[it.slot_].event = event;
+
+         size_t const pos = slots_[it.slot_].pos;
+         heap_[pos] = makeEntry(event, it.slot_);
+         siftAt(pos);
+      }
+
+      iterator begin() const
+      {
+         if (heap_.empty())
+            return end();
+         return iterator (this, heap_.front().slot);
+      }
+
+      iterator end() const
+      {
+         return iterator (this, npos);
+      }
+
+      size_t size() const { return heap_.size(); }
+      bool empty() const { return heap_.empty(); }
+
+      // Events in the order they would be popped, begin() to end() only follows the heap
+      void ordered( std::vector< EventData > &events ) const
+      {
+         std::vector< HeapEntry > entries (heap_);
+         std::sort(entries.begin(), entries.end(), &EventQueue::before);
+
+         events.clear();
+         events.reserve(entries.size());
+         for (size_t i = 0; i != entries.size(); ++i)
+            events.push_back(slots_[entries[i].slot].event);
+      }
+
+      void clear()
+      {
+         heap_.clear();
+         slots_.clear();
+         freeSlots_.clear();
+         stamp_ = 0;
+      }
+
+   private:
+      HeapEntry makeEntry( EventData const &event, size_t slot )
+      {
+         HeapEntry entry;
+         entry.t = event.t;
+         entry.type = event.type;
+         entry.stamp = stamp_++;
+         entry.slot = slot;
+         return entry;
+      }
+
+      // EventPriorityLess, newer first for equal events
+      static bool before( HeapEntry const &a, HeapEntry const &b )
+      {
+         if (a.t != b.t)
+            return a.t < b.t;
+         if (a.type != b.type)
+            return a.type < b.type;
+         return a.stamp > b.stamp;
+      }
+
+      void place( size_t pos, HeapEntry const &entry )
+      {
+         heap_[pos] = entry;
+         slots_[entry.slot].pos = pos;
       }
 
-      EventData const &top()
+      void siftUp( size_t pos )
       {
-         return *begin();
+         HeapEntry const entry = heap_[pos];
+         while (pos > 0)
+         {
+            size_t const parent = (pos - 1) / arity;
+            if (!before(entry, heap_[parent]))
+               break;
+            place(pos, heap_[parent]);
+            pos = parent;
+         }
+         place(pos, entry);
+      }
+
+      void siftDown( size_t pos )
+      {
+         HeapEntry const entry = heap_[pos];
+         size_t const size = heap_.size();
+         for (;;)
+         {
+            size_t const first = pos * arity + 1;
+            if (first >= size)
+               break;
+
+            size_t const last = std::min(first + arity, size);
+            size_t best = first;
+            for (size_t child = first + 1; child < last; ++child)
+               if (before(heap_[child], heap_[best]))
+                  best = child;
+
+            if (!before(heap_[best], entry))
+               break;
+            place(pos, heap_[best]);
+            pos = best;
+         }
+         place(pos, entry);
       }
+
+      void siftAt( size_t pos )
+      {
+         if (pos > 0 && before(heap_[pos], heap_[(pos - 1) / arity]))
+            siftUp(pos);
+         else
+            siftDown(pos);
+      }
+
+      void removeAt( size_t pos )
+      {
+         size_t const slot = heap_[pos].slot;
+         slots_[slot].pos = npos;
+         freeSlots_.push_back(slot);
+
+         HeapEntry const last = heap_.back();
+         heap_.pop_back();
+         if (pos < heap_.size())
+         {
+            place(pos, last);
+            siftAt(pos);
+         }
+      }
+
+   private:
+      std::vector< HeapEntry > heap_;
+      std::vector< Slot > slots_;
+      std::vector< size_t > freeSlots_;
+      size_t stamp_;
    };
 
    typedef EventQueue::iterator queue_iterator;
@@ -725,11 +725,11 @@ public: //private:
       {
          event.intersection = intersection;
          event.eventHost = eventHost;
-         ss::queue_iterator qIt = queue_.push(event);
          newEvents_.push_back(event);
          if (dcel_.vertex(event.eventHost).data.iter != queue_.end())
-            queue_.erase(dcel_.vertex(event.eventHost).data.iter);
-         dcel_.vertex(event.eventHost).data.iter = qIt;
+            queue_.update(dcel_.vertex(event.eventHost).data.iter, event);
+         else
+            dcel_.vertex(event.eventHost).data.iter = queue_.push(event);
       }
       else if (addAnyway)
       {
@@ -1357,10 +1357,12 @@ public: //private:
       }
       stream << std::endl << std::endl;
 
-      stream << queue_.size() << ' ';
-      for (ss::EventQueue::iterator qIt = queue_.begin(); qIt != queue_.end(); ++qIt)
+      std::vector< ss::EventData > events;
+      queue_.ordered(events);
+      stream << events.size() << ' ';
+      for (size_t i = 0; i < events.size(); ++i)
       {
-         qIt->dump(stream);
+         events[i].dump(stream);
          stream << ' ';
       }
       stream << std::endl << std::endl;
@@ -1411,12 +1413,13 @@ public: //private:
 
       size_t queueSize;
       stream >> queueSize;
+      std::vector< ss::EventData > events (queueSize);
       for (size_t i = 0; i < queueSize; ++i)
-      {
-         ss::EventData ev;
-         ev.restore(stream);
-         queue_.insert(queue_.end(), ev);
-      }
+         events[i].restore(stream);
+      // dumped in pop order; pushed from the end, so of equal events the first dumped is the newest
+      // and is popped first again
+      for (size_t i = queueSize; i > 0; --i)
+         queue_.push(events[i - 1]);
 
       dcel_.restore(stream);
       for (size_t v = 0; v < dcel_.verticesSize(); ++v)
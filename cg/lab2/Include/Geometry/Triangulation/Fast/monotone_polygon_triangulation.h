@@ -3,6 +3,7 @@
 #include <stack>
 
 #include "Geometry/dcel/dcel.h"
+#include "Geometry/cgal_predicates.h"
 
 namespace cg
 {
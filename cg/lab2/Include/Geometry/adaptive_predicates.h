@@ -0,0 +1,618 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include "Geometry\segment_2_intersection.h"
+
+// Robust predicates without CGAL: floating point filter with adaptive exact fallback,
+// after J.R. Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast Robust
+// Geometric Predicates" (1997).
+//
+//    orient2d(a, b, c)    > 0 if a, b, c go counterclockwise, < 0 if clockwise, 0 if collinear
+//    orient3d(a, b, c, d) > 0 if d is below the plane of a, b, c (counterclockwise seen from above)
+//    incircle(a, b, c, d) > 0 if d is inside the circle through a, b, c (counterclockwise)
+//
+// The sign of the result is exact, the value is an approximation of the determinant.
+// The common case costs a few multiplications more than the plain determinant, the exact
+// expansion arithmetic runs only when the filter can't decide.
+//
+// classify_segments() tells disjoint / intersect / overlap exactly; the intersection point
+// is computed from exact determinants and rounded, so it is within a few ulps, not the nearest double.
+//
+// The code relies on IEEE double rounding: SSE2 or x87 in 53-bit precision mode
+// (the MSVC default), no /fp:fast.
+//
+// adaptive_predicates has the same static interface as cgal_predicates (cgal_predicates.h),
+// the algorithms taking a Predicates parameter accept both.
+
+namespace cg
+{
+
+enum VecOrientation
+{
+   VO_LEFT = 0,
+   VO_RIGHT,
+   VO_COLLINEAR
+};
+
+namespace adaptive
+{
+
+namespace details
+{
+   // eps = 2^-53, splitter = 2^27 + 1, error bounds from the paper
+   double const epsilon        = 1.1102230246251565e-16;
+   double const splitter       = 134217729.0;
+   double const resulterrbound = (3.0 + 8.0 * epsilon) * epsilon;
+   double const ccwerrboundA   = (3.0 + 16.0 * epsilon) * epsilon;
+   double const ccwerrboundB   = (2.0 + 12.0 * epsilon) * epsilon;
+   double const ccwerrboundC   = (9.0 + 64.0 * epsilon) * epsilon * epsilon;
+   double const o3derrboundA   = (7.0 + 56.0 * epsilon) * epsilon;
+   double const iccerrboundA   = (10.0 + 96.0 * epsilon) * epsilon;
+
+   // x + y == a + b exactly, |a| >= |b|
+   __forceinline void fast_two_sum( double a, double b, double &x, double &y )
+   {
+      x = a + b;
+      double const bvirt = x - a;
+      y = b - bvirt;
+   }
+
+   __forceinline void two_sum( double a, double b, double &x, double &y )
+   {
+      x = a + b;
+      double const bvirt = x - a;
+      double const avirt = x - bvirt;
+      y = (a - avirt) + (b - bvirt);
+   }
+
+   // y of x = a - b given
+   __forceinline double two_diff_tail( double a, double b, double x )
+   {
+      double const bvirt = a - x;
+      double const avirt = x + bvirt;
+      return (a - avirt) + (bvirt - b);
+   }
+
+   __forceinline void two_diff( double a, double b, double &x, double &y )
+   {
+      x = a - b;
+      y = two_diff_tail(a, b, x);
+   }
+
+   __forceinline void split( double a, double &hi, double &lo )
+   {
+      double const c = splitter * a;
+      double const abig = c - a;
+      hi = c - abig;
+      lo = a - hi;
+   }
+
+   __forceinline void two_product_presplit( double a, double b, double bhi, double blo, double &x, double &y )
+   {
+      x = a * b;
+
+      double ahi, alo;
+      split(a, ahi, alo);
+
+      double const err1 = x - ahi * bhi;
+      double const err2 = err1 - alo * bhi;
+      double const err3 = err2 - ahi * blo;
+      y = alo * blo - err3;
+   }
+
+   __forceinline void two_product( double a, double b, double &x, double &y )
+   {
+      double bhi, blo;
+      split(b, bhi, blo);
+      two_product_presplit(a, b, bhi, blo, x, y);
+   }
+
+   // (a1 + a0) - b
+   __forceinline void two_one_diff( double a1, double a0, double b, double &x2, double &x1, double &x0 )
+   {
+      double i;
+      two_diff(a0, b, i, x0);
+      two_sum(a1, i, x2, x1);
+   }
+
+   // x[0..3] = (a1 + a0) - (b1 + b0)
+   __forceinline void two_two_diff( double a1, double a0, double b1, double b0, double *x )
+   {
+      double j, z;
+      two_one_diff(a1, a0, b0, j, z, x[0]);
+      two_one_diff(j, z, b1, x[3], x[2], x[1]);
+   }
+
+   // x[0..3] = a.x * b.y - b.x * a.y
+   __forceinline void cross_expansion( point_2 const &a, point_2 const &b, double *x )
+   {
+      double ab1, ab0, ba1, ba0;
+      two_product(a.x, b.y, ab1, ab0);
+      two_product(b.x, a.y, ba1, ba0);
+      two_two_diff(ab1, ab0, ba1, ba0, x);
+   }
+
+   // h = e + f, nonoverlapping expansions in increasing magnitude, zeros removed; returns length of h
+   inline int expansion_sum( int elen, double const *e, int flen, double const *f, double *h )
+   {
+      int eindex = 0, findex = 0, hindex = 0;
+      double enow = e[0], fnow = f[0];
+      double q, qnew, hh;
+
+      if ((fnow > enow) == (fnow > -enow))
+      {
+         q = enow;
+         enow = ++eindex < elen ? e[eindex] : 0;
+      }
+      else
+      {
+         q = fnow;
+         fnow = ++findex < flen ? f[findex] : 0;
+      }
+
+      if (eindex < elen && findex < flen)
+      {
+         if ((fnow > enow) == (fnow > -enow))
+         {
+            fast_two_sum(enow, q, qnew, hh);
+            enow = ++eindex < elen ? e[eindex] : 0;
+         }
+         else
+         {
+            fast_two_sum(fnow, q, qnew, hh);
+            fnow = ++findex < flen ? f[findex] : 0;
+         }
+         q = qnew;
+         if (hh != 0)
+            h[hindex++] = hh;
+
+         while (eindex < elen && findex < flen)
+         {
+            if ((fnow > enow) == (fnow > -enow))
+            {
+               two_sum(q, enow, qnew, hh);
+               enow = ++eindex < elen ? e[eindex] : 0;
+            }
+            else
+            {
+               two_sum(q, fnow, qnew, hh);
+               fnow = ++findex < flen ? f[findex] : 0;
+            }
+            q = qnew;
+            if (hh != 0)
+               h[hindex++] = hh;
+         }
+      }
+
+      for (; eindex < elen; enow = ++eindex < elen ? e[eindex] : 0)
+      {
+         two_sum(q, enow, qnew, hh);
+         q = qnew;
+         if (hh != 0)
+            h[hindex++] = hh;
+      }
+
+      for (; findex < flen; fnow = ++findex < flen ? f[findex] : 0)
+      {
+         two_sum(q, fnow, qnew, hh);
+         q = qnew;
+         if (hh != 0)
+            h[hindex++] = hh;
+      }
+
+      if (q != 0 || hindex == 0)
+         h[hindex++] = q;
+
+      return hindex;
+   }
+
+   // h = e * b, zeros removed; returns length of h
+   inline int scale_expansion( int elen, double const *e, double b, double *h )
+   {
+      double bhi, blo;
+      split(b, bhi, blo);
+
+      double q, hh;
+      two_product_presplit(e[0], b, bhi, blo, q, hh);
+
+      int hindex = 0;
+      if (hh != 0)
+         h[hindex++] = hh;
+
+      for (int i = 1; i < elen; ++i)
+      {
+         double product1, product0, sum;
+         two_product_presplit(e[i], b, bhi, blo, product1, product0);
+
+         two_sum(q, product0, sum, hh);
+         if (hh != 0)
+            h[hindex++] = hh;
+
+         fast_two_sum(product1, sum, q, hh);
+         if (hh != 0)
+            h[hindex++] = hh;
+      }
+
+      if (q != 0 || hindex == 0)
+         h[hindex++] = q;
+
+      return hindex;
+   }
+
+   inline double estimate( int elen, double const *e )
+   {
+      double q = e[0];
+      for (int i = 1; i < elen; ++i)
+         q += e[i];
+      return q;
+   }
+
+   inline void negate( int elen, double *e )
+   {
+      for (int i = 0; i < elen; ++i)
+         e[i] = -e[i];
+   }
+
+   // exact orient2d as an expansion of up to 12 components
+   inline int orient2d_exact( point_2 const &a, point_2 const &b, point_2 const &c, double *w )
+   {
+      double ab[4], bc[4], ca[4], v[8];
+      cross_expansion(a, b, ab);
+      cross_expansion(b, c, bc);
+      cross_expansion(c, a, ca);
+
+      int const vlen = expansion_sum(4, ab, 4, bc, v);
+      return expansion_sum(vlen, v, 4, ca, w);
+   }
+
+   inline double orient2d_adapt( point_2 const &a, point_2 const &b, point_2 const &c, double detsum )
+   {
+      double const acx = a.x - c.x, bcx = b.x - c.x;
+      double const acy = a.y - c.y, bcy = b.y - c.y;
+
+      double detleft, detlefttail, detright, detrighttail;
+      two_product(acx, bcy, detleft, detlefttail);
+      two_product(acy, bcx, detright, detrighttail);
+
+      double B[4];
+      two_two_diff(detleft, detlefttail, detright, detrighttail, B);
+
+      double det = estimate(4, B);
+      double errbound = ccwerrboundB * detsum;
+      if (det >= errbound || -det >= errbound)
+         return det;
+
+      double const acxtail = two_diff_tail(a.x, c.x, acx);
+      double const bcxtail = two_diff_tail(b.x, c.x, bcx);
+      double const acytail = two_diff_tail(a.y, c.y, acy);
+      double const bcytail = two_diff_tail(b.y, c.y, bcy);
+
+      if (acxtail == 0 && acytail == 0 && bcxtail == 0 && bcytail == 0)
+         return det;
+
+      errbound = ccwerrboundC * detsum + resulterrbound * std::fabs(det);
+      det += (acx * bcytail + bcy * acxtail) - (acy * bcxtail + bcx * acytail);
+      if (det >= errbound || -det >= errbound)
+         return det;
+
+      double s1, s0, t1, t0, u[4];
+      double C1[8], C2[12], D[16];
+
+      two_product(acxtail, bcy, s1, s0);
+      two_product(acytail, bcx, t1, t0);
+      two_two_diff(s1, s0, t1, t0, u);
+      int const c1len = expansion_sum(4, B, 4, u, C1);
+
+      two_product(acx, bcytail, s1, s0);
+      two_product(acy, bcxtail, t1, t0);
+      two_two_diff(s1, s0, t1, t0, u);
+      int const c2len = expansion_sum(c1len, C1, 4, u, C2);
+
+      two_product(acxtail, bcytail, s1, s0);
+      two_product(acytail, bcxtail, t1, t0);
+      two_two_diff(s1, s0, t1, t0, u);
+      int const dlen = expansion_sum(c2len, C2, 4, u, D);
+
+      return D[dlen - 1];
+   }
+
+   // cross products of all pairs of a, b, c, d and the three-point terms built from them
+   struct lifted_terms
+   {
+      lifted_terms( point_2 const &a, point_2 const &b, point_2 const &c, point_2 const &d )
+      {
+         double ab[4], bc[4], cd[4], da[4], ac[4], bd[4], temp8[8];
+         cross_expansion(a, b, ab);
+         cross_expansion(b, c, bc);
+         cross_expansion(c, d, cd);
+         cross_expansion(d, a, da);
+         cross_expansion(a, c, ac);
+         cross_expansion(b, d, bd);
+
+         int templen = expansion_sum(4, cd, 4, da, temp8);
+         cdalen = expansion_sum(templen, temp8, 4, ac, cda);
+         templen = expansion_sum(4, da, 4, ab, temp8);
+         dablen = expansion_sum(templen, temp8, 4, bd, dab);
+
+         negate(4, bd);
+         negate(4, ac);
+
+         templen = expansion_sum(4, ab, 4, bc, temp8);
+         abclen = expansion_sum(templen, temp8, 4, ac, abc);
+         templen = expansion_sum(4, bc, 4, cd, temp8);
+         bcdlen = expansion_sum(templen, temp8, 4, bd, bcd);
+      }
+
+      double abc[12], bcd[12], cda[12], dab[12];
+      int    abclen, bcdlen, cdalen, dablen;
+   };
+
+   inline double orient3d_exact( point_3 const &a, point_3 const &b, point_3 const &c, point_3 const &d )
+   {
+      lifted_terms const t (point_2(a.x, a.y), point_2(b.x, b.y), point_2(c.x, c.y), point_2(d.x, d.y));
+
+      double adet[24], bdet[24], cdet[24], ddet[24], abdet[48], cddet[48], deter[96];
+
+      int const alen = scale_expansion(t.bcdlen, t.bcd, a.z, adet);
+      int const blen = scale_expansion(t.cdalen, t.cda, -b.z, bdet);
+      int const clen = scale_expansion(t.dablen, t.dab, c.z, cdet);
+      int const dlen = scale_expansion(t.abclen, t.abc, -d.z, ddet);
+
+      int const ablen = expansion_sum(alen, adet, blen, bdet, abdet);
+      int const cdlen = expansion_sum(clen, cdet, dlen, ddet, cddet);
+      int const deterlen = expansion_sum(ablen, abdet, cdlen, cddet, deter);
+
+      return deter[deterlen - 1];
+   }
+
+   // det * (p.x^2 + p.y^2) * sign
+   inline int lift_expansion( int len, double const *det, point_2 const &p, double sign, double *h )
+   {
+      double det24x[24], det48x[48], det24y[24], det48y[48];
+
+      int const xlen  = scale_expansion(len, det, p.x, det24x);
+      int const xxlen = scale_expansion(xlen, det24x, sign * p.x, det48x);
+      int const ylen  = scale_expansion(len, det, p.y, det24y);
+      int const yylen = scale_expansion(ylen, det24y, sign * p.y, det48y);
+
+      return expansion_sum(xxlen, det48x, yylen, det48y, h);
+   }
+
+   inline double incircle_exact( point_2 const &a, point_2 const &b, point_2 const &c, point_2 const &d )
+   {
+      lifted_terms const t (a, b, c, d);
+
+      double adet[96], bdet[96], cdet[96], ddet[96], abdet[192], cddet[192], deter[384];
+
+      int const alen = lift_expansion(t.bcdlen, t.bcd, a,  1, adet);
+      int const blen = lift_expansion(t.cdalen, t.cda, b, -1, bdet);
+      int const clen = lift_expansion(t.dablen, t.dab, c,  1, cdet);
+      int const dlen = lift_expansion(t.abclen, t.abc, d, -1, ddet);
+
+      int const ablen = expansion_sum(alen, adet, blen, bdet, abdet);
+      int const cdlen = expansion_sum(clen, cdet, dlen, ddet, cddet);
+      int const deterlen = expansion_sum(ablen, abdet, cdlen, cddet, deter);
+
+      return deter[deterlen - 1];
+   }
+
+   inline int sign( double x )
+   {
+      return x > 0 ? 1 : (x < 0 ? -1 : 0);
+   }
+} // End of 'details' namespace
+
+inline double orient2d( point_2 const &a, point_2 const &b, point_2 const &c )
+{
+   double const detleft = (a.x - c.x) * (b.y - c.y);
+   double const detright = (a.y - c.y) * (b.x - c.x);
+   double const det = detleft - detright;
+
+   double detsum;
+   if (detleft > 0)
+   {
+      if (detright <= 0)
+         return det;
+      detsum = detleft + detright;
+   }
+   else if (detleft < 0)
+   {
+      if (detright >= 0)
+         return det;
+      detsum = -detleft - detright;
+   }
+   else
+      return det;
+
+   double const errbound = details::ccwerrboundA * detsum;
+   if (det >= errbound || -det >= errbound)
+      return det;
+
+   return details::orient2d_adapt(a, b, c, detsum);
+}
+
+inline double orient3d( point_3 const &a, point_3 const &b, point_3 const &c, point_3 const &d )
+{
+   double const adx = a.x - d.x, bdx = b.x - d.x, cdx = c.x - d.x;
+   double const ady = a.y - d.y, bdy = b.y - d.y, cdy = c.y - d.y;
+   double const adz = a.z - d.z, bdz = b.z - d.z, cdz = c.z - d.z;
+
+   double const bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+   double const cdxady = cdx * ady, adxcdy = adx * cdy;
+   double const adxbdy = adx * bdy, bdxady = bdx * ady;
+
+   double const det =
+        adz * (bdxcdy - cdxbdy)
+      + bdz * (cdxady - adxcdy)
+      + cdz * (adxbdy - bdxady);
+
+   double const permanent =
+        (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * std::fabs(adz)
+      + (std::fabs(cdxady) + std::fabs(adxcdy)) * std::fabs(bdz)
+      + (std::fabs(adxbdy) + std::fabs(bdxady)) * std::fabs(cdz);
+
+   double const errbound = details::o3derrboundA * permanent;
+   if (det > errbound || -det > errbound)
+      return det;
+
+   return details::orient3d_exact(a, b, c, d);
+}
+
+inline double incircle( point_2 const &a, point_2 const &b, point_2 const &c, point_2 const &d )
+{
+   double const adx = a.x - d.x, bdx = b.x - d.x, cdx = c.x - d.x;
+   double const ady = a.y - d.y, bdy = b.y - d.y, cdy = c.y - d.y;
+
+   double const bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+   double const cdxady = cdx * ady, adxcdy = adx * cdy;
+   double const adxbdy = adx * bdy, bdxady = bdx * ady;
+
+   double const alift = adx * adx + ady * ady;
+   double const blift = bdx * bdx + bdy * bdy;
+   double const clift = cdx * cdx + cdy * cdy;
+
+   double const det =
+        alift * (bdxcdy - cdxbdy)
+      + blift * (cdxady - adxcdy)
+      + clift * (adxbdy - bdxady);
+
+   double const permanent =
+        (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * alift
+      + (std::fabs(cdxady) + std::fabs(adxcdy)) * blift
+      + (std::fabs(adxbdy) + std::fabs(bdxady)) * clift;
+
+   double const errbound = details::iccerrboundA * permanent;
+   if (det > errbound || -det > errbound)
+      return det;
+
+   return details::incircle_exact(a, b, c, d);
+}
+
+inline VecOrientation orientation( point_2 const &a, point_2 const &b, point_2 const &c )
+{
+   double const det = orient2d(a, b, c);
+   return det > 0 ? VO_LEFT : (det < 0 ? VO_RIGHT : VO_COLLINEAR);
+}
+
+// of vectors
+inline VecOrientation orientation( point_2 const &p, point_2 const &q )
+{
+   return orientation(point_2 (0, 0), p, q);
+}
+
+// q lies between p and r, the points are collinear
+inline bool collinear_are_ordered_along_line( point_2 const &p, point_2 const &q, point_2 const &r )
+{
+   if (p.x < q.x) return !(r.x < q.x);
+   if (q.x < p.x) return !(q.x < r.x);
+   if (p.y < q.y) return !(r.y < q.y);
+   if (q.y < p.y) return !(q.y < r.y);
+   return true;
+}
+
+// Exact classification, r1 is the intersection point, (r1, r2) the common part for overlap
+inline intersection_type classify_segments( segment_2 const &s, segment_2 const &t, point_2 &r1, point_2 &r2 )
+{
+   using details::sign;
+
+   if (!has_intersection(rectangle_2 (s.P0(), s.P1()), rectangle_2 (t.P0(), t.P1())))
+      return disjoint;
+
+   int const s0 = sign(orient2d(t.P0(), t.P1(), s.P0()));
+   int const s1 = sign(orient2d(t.P0(), t.P1(), s.P1()));
+   int const t0 = sign(orient2d(s.P0(), s.P1(), t.P0()));
+   int const t1 = sign(orient2d(s.P0(), s.P1(), t.P1()));
+
+   if (s0 * s1 > 0 || t0 * t1 > 0)
+      return disjoint;
+
+   if (s0 == 0 && s1 == 0 && t0 == 0 && t1 == 0)
+   {
+      // collinear, common part of the projections to x, or to y for vertical segments
+      bool const by_x = s.P0().x != s.P1().x || t.P0().x != t.P1().x;
+
+      point_2 slo = s.P0(), shi = s.P1(), tlo = t.P0(), thi = t.P1();
+      if (by_x ? shi.x < slo.x : shi.y < slo.y) std::swap(slo, shi);
+      if (by_x ? thi.x < tlo.x : thi.y < tlo.y) std::swap(tlo, thi);
+
+      point_2 const &lo = (by_x ? tlo.x > slo.x : tlo.y > slo.y) ? tlo : slo;
+      point_2 const &hi = (by_x ? thi.x < shi.x : thi.y < shi.y) ? thi : shi;
+
+      if (by_x ? lo.x > hi.x : lo.y > hi.y)
+         return disjoint;
+
+      r1 = lo;
+      if (lo == hi)
+         return intersect;
+
+      r2 = hi;
+      return overlap;
+   }
+
+   // touching in an endpoint
+   if (s0 == 0) { r1 = s.P0(); return intersect; }
+   if (s1 == 0) { r1 = s.P1(); return intersect; }
+   if (t0 == 0) { r1 = t.P0(); return intersect; }
+   if (t1 == 0) { r1 = t.P1(); return intersect; }
+
+   // proper crossing: s.P0() + (s.P1() - s.P0()) * a / (a - b), a and b of opposite signs
+   double w[12];
+   double const a = details::estimate(details::orient2d_exact(t.P0(), t.P1(), s.P0(), w), w);
+   double const b = details::estimate(details::orient2d_exact(t.P0(), t.P1(), s.P1(), w), w);
+
+   r1 = s.P0() + (s.P1() - s.P0()) * (a / (a - b));
+   r1 = (rectangle_2 (s.P0(), s.P1()) & rectangle_2 (t.P0(), t.P1())).closest_point(r1);
+
+   return intersect;
+}
+
+} // End of 'adaptive' namespace
+
+// Predicates policy, see cgal_predicates for the CGAL one
+struct adaptive_predicates
+{
+   static VecOrientation orientation( point_2 const &a, point_2 const &b, point_2 const &c )
+   {
+      return adaptive::orientation(a, b, c);
+   }
+
+   static VecOrientation orientation( point_2 const &p, point_2 const &q )
+   {
+      return adaptive::orientation(p, q);
+   }
+
+   static bool left_turn_strict( point_2 const &a, point_2 const &b, point_2 const &c )
+   {
+      return adaptive::orient2d(a, b, c) > 0;
+   }
+
+   static bool right_turn_strict( point_2 const &a, point_2 const &b, point_2 const &c )
+   {
+      return adaptive::orient2d(a, b, c) < 0;
+   }
+
+   static bool collinear( point_2 const &a, point_2 const &b, point_2 const &c )
+   {
+      return adaptive::orient2d(a, b, c) == 0;
+   }
+
+   static bool collinear_are_ordered_along_line( point_2 const &p, point_2 const &q, point_2 const &r )
+   {
+      return adaptive::collinear_are_ordered_along_line(p, q, r);
+   }
+
+   static intersection_type isect_segments( segment_2 const &s, segment_2 const &t, point_2 &r1, point_2 &r2 )
+   {
+      return adaptive::classify_segments(s, t, r1, r2);
+   }
+
+   // the point of classify_segments is as good as it gets here
+   static intersection_type exact_isect_segments( segment_2 const &s, segment_2 const &t, point_2 &r1, point_2 &r2 )
+   {
+      return adaptive::classify_segments(s, t, r1, r2);
+   }
+};
+
+} // End of 'cg' namespace
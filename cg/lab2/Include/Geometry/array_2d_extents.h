@@ -3,6 +3,10 @@
 #include "common\assert.h"
 #include "primitives\point.h"
 
+#if defined(CG_USE_BMI2) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
 namespace cg
 {
     namespace extents
@@ -48,9 +52,9 @@ namespace cg
         struct columnwise
         {
             template <class E>
-                static size_t principal(E const & ext)
+                static int to1D(E const & ext, point_2i const & idx)
             {
-                return ext.height();
+                return int(idx.x * ext.height() + idx.y);
             }
             
             template <class E>
@@ -63,9 +67,9 @@ namespace cg
         struct rowwise
         {
             template <class E>
-                static size_t principal(E const & ext)
+                static int to1D(E const & ext, point_2i const & idx)
             {
-                return ext.width();
+                return int(idx.y * ext.width() + idx.x);
             }
 
             template <class E>
@@ -74,6 +78,118 @@ namespace cg
                 return point_2i(idx % (int)ext.width(), idx / (int)ext.width());
             }
         };
+
+        namespace details
+        {
+            // bits 0..15 of v to the even bits of the result
+            __forceinline unsigned spread_bits(unsigned v)
+            {
+#if defined(CG_USE_BMI2) || defined(__BMI2__)
+                return _pdep_u32(v, 0x55555555);
+#else
+                v = (v | (v << 8)) & 0x00FF00FF;
+                v = (v | (v << 4)) & 0x0F0F0F0F;
+                v = (v | (v << 2)) & 0x33333333;
+                v = (v | (v << 1)) & 0x55555555;
+                return v;
+#endif
+            }
+
+            // the even bits of v to bits 0..15 of the result
+            __forceinline unsigned compact_bits(unsigned v)
+            {
+#if defined(CG_USE_BMI2) || defined(__BMI2__)
+                return _pext_u32(v, 0x55555555);
+#else
+                v &= 0x55555555;
+                v = (v | (v >> 1)) & 0x33333333;
+                v = (v | (v >> 2)) & 0x0F0F0F0F;
+                v = (v | (v >> 4)) & 0x00FF00FF;
+                v = (v | (v >> 8)) & 0x0000FFFF;
+                return v;
+#endif
+            }
+
+            // Z-order index of (x, y), x goes to the even bits
+            __forceinline unsigned interleave(unsigned x, unsigned y)
+            {
+                return spread_bits(x) | (spread_bits(y) << 1);
+            }
+
+            __forceinline point_2i deinterleave(unsigned z)
+            {
+                return point_2i((int)compact_bits(z), (int)compact_bits(z >> 1));
+            }
+
+            // Cells are grouped in tiles of (1 << LogTile) x (1 << LogTile), tiles go row by row.
+            // The last tile column and row may be narrower, so there is no padding and
+            // size() stays width * height, which visitors and serialization rely on.
+            // InTile orders the cells inside a full tile, clipped tiles are always rowwise.
+            template <int LogTile, class InTile>
+                struct tiled_layout
+            {
+                enum { tile = 1 << LogTile, mask = tile - 1 };
+
+                template <class E>
+                    static __forceinline int to1D(E const & ext, point_2i const & idx)
+                {
+                    int const w    = (int)ext.width();
+                    int const h    = (int)ext.height();
+                    int const band = idx.y & ~mask;
+                    int const col  = idx.x & ~mask;
+
+                    if (col + tile <= w && band + tile <= h)
+                        return band * w + (col << LogTile) + InTile::to1D(idx.x & mask, idx.y & mask);
+
+                    // clipped tile
+                    int const bh = cg::min((int)tile, h - band);
+                    int const tw = cg::min((int)tile, w - col);
+                    return band * w + col * bh + (idx.y & mask) * tw + (idx.x & mask);
+                }
+
+                template <class E>
+                    static point_2i to2D(E const & ext, int idx)
+                {
+                    int const w    = (int)ext.width();
+                    int const band = idx / (tile * w) * tile;
+                    int const bh   = cg::min((int)tile, (int)ext.height() - band);
+                    int       rem  = idx - band * w;
+                    int const col  = rem / (tile * bh) * tile;
+                    int const tw   = cg::min((int)tile, w - col);
+
+                    rem -= col * bh;
+                    if (bh == tile && tw == tile)
+                        return point_2i(col, band) + InTile::to2D(rem);
+
+                    return point_2i(col + rem % tw, band + rem / tw);
+                }
+            };
+
+            template <int LogTile>
+                struct rowwise_tile
+            {
+                static __forceinline int      to1D(int x, int y) { return (y << LogTile) + x; }
+                static __forceinline point_2i to2D(int idx)      { return point_2i(idx & ((1 << LogTile) - 1), idx >> LogTile); }
+            };
+
+            struct morton_tile
+            {
+                static __forceinline int      to1D(int x, int y) { return (int)interleave(x, y); }
+                static __forceinline point_2i to2D(int idx)      { return deinterleave(idx); }
+            };
+        }
+
+        // 8x8 blocks by default: a 2D window touches few cache lines and pages
+        template <int LogTile = 3>
+            struct tiled : details::tiled_layout<LogTile, details::rowwise_tile<LogTile> >
+        {};
+
+        // Z-order inside 16x16 blocks, so also the neighbours across a tile row are close.
+        // A Z-curve over the whole array would need padding up to powers of two.
+        // Build with CG_USE_BMI2 (or -mbmi2) to get pdep/pext for the bit interleaving.
+        template <int LogTile = 4>
+            struct morton : details::tiled_layout<LogTile, details::morton_tile>
+        {};
     }
 
     // Shape - ,    : .  
@@ -111,9 +227,9 @@ namespace cg
             Assert(size_t(idx.y) < height());
         }
 
-        linear_index to1D(point_2i const & idx) const
+        __forceinline linear_index to1D(point_2i const & idx) const
         {   
-            return linear_index(idx.y * Selector::principal(*this) + idx.x);
+            return Selector::to1D(*this, idx);
         }
 
         point_2i to2D(linear_index const & idx) const
@@ -10,17 +10,11 @@
 #include "Geometry\cgal\enum.h"
 #include "Geometry\segment_2_intersection.h"
 #include "Geometry\primitives\line.h"
+#include "Geometry\adaptive_predicates.h"
 
 namespace cg
 {
 
-enum VecOrientation
-{
-   VO_LEFT = 0,
-   VO_RIGHT,
-   VO_COLLINEAR
-};
-
 namespace details
 {
    typedef CGAL::Exact_predicates_inexact_constructions_kernel CGAL_Kernel;
@@ -335,4 +329,50 @@ inline bool is_point_on_segment( cg::point_2 const &p, cg::segment_2 const &seg
    return robust_collinear_are_ordered_along_line(seg.P0(), p, seg.P1());
 }
 
+// Predicates policy for SegmentXLess, DCEL::OrientationPredicate, PSLGOverlayProcessor,
+// robust_segments_intersector and SegmentsIntersections, same interface as adaptive_predicates
+// (adaptive_predicates.h). The default one is picked in default_predicates.h
+struct cgal_predicates
+{
+   static VecOrientation orientation( cg::point_2 const &a, cg::point_2 const &b, cg::point_2 const &c )
+   {
+      return details::robust_orientation(a, b, c);
+   }
+
+   static VecOrientation orientation( cg::point_2 const &p, cg::point_2 const &q )
+   {
+      return details::robust_orientation(p, q);
+   }
+
+   static bool left_turn_strict( cg::point_2 const &a, cg::point_2 const &b, cg::point_2 const &c )
+   {
+      return details::robust_left_turn(a, b, c);
+   }
+
+   static bool right_turn_strict( cg::point_2 const &a, cg::point_2 const &b, cg::point_2 const &c )
+   {
+      return details::robust_right_turn(a, b, c);
+   }
+
+   static bool collinear( cg::point_2 const &a, cg::point_2 const &b, cg::point_2 const &c )
+   {
+      return details::robust_collinear(a, b, c);
+   }
+
+   static bool collinear_are_ordered_along_line( cg::point_2 const &p, cg::point_2 const &q, cg::point_2 const &r )
+   {
+      return details::robust_collinear_are_ordered_along_line(p, q, r);
+   }
+
+   static cg::intersection_type isect_segments( cg::segment_2 const &s, cg::segment_2 const &t, cg::point_2 &r1, cg::point_2 &r2 )
+   {
+      return details::robust_isect_segments(s, t, r1, r2);
+   }
+
+   static cg::intersection_type exact_isect_segments( cg::segment_2 const &s, cg::segment_2 const &t, cg::point_2 &r1, cg::point_2 &r2 )
+   {
+      return details::exact_isect_segments(s, t, r1, r2);
+   }
+};
+
 } // End of 'cg' namespace
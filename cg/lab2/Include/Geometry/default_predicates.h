@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Geometry\adaptive_predicates.h"
+
+// Predicates policy the algorithms use by default: SegmentXLess, DCEL::RobustOrientationPredicate,
+// PSLGOverlayProcessor, robust_segments_intersector and SegmentsIntersections.
+// CG_ADAPTIVE_PREDICATES switches it to adaptive_predicates, and then CGAL is not included.
+
+#ifndef CG_ADAPTIVE_PREDICATES
+#include "Geometry\cgal_predicates.h"
+#endif
+
+namespace cg
+{
+
+#ifdef CG_ADAPTIVE_PREDICATES
+   typedef adaptive_predicates default_predicates;
+#else
+   typedef cgal_predicates     default_predicates;
+#endif
+
+} // End of 'cg' namespace
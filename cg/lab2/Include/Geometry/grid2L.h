@@ -3,6 +3,7 @@
 #include "Grid2L\grid2l_Impl.h"
 #include "Grid2L\Grid2L_Mapped.h"
 #include "Grid2L\visit_grid2l_by_point.h"
+#include "Grid2L\visit_grid2l_by_points.h"
 #include "Grid2l\visit_grid2l_by_segment.h"
 #include "Grid2L\visit_grid2l_by_triangle.h"
 #include "Grid2L\visit_grid2l_by_rectangle.h"
@@ -59,6 +60,12 @@ namespace cg
         return visit_grid2l_by_triangle<MappedGrid2L<T> >::process(grid, t, processor);
     }
 
+    template <class T, class Processor>
+        inline bool visit(MappedGrid2L<T> const & grid, triangle_2 const &t, Processor &processor)
+    {
+        return visit_grid2l_by_triangle<MappedGrid2L<T> >::process(const_cast<MappedGrid2L<T>&>(grid), t, processor);
+    }
+
     template <class T, class B, class H, class Processor>
         inline bool visit_every_cell(MappedGrid2L<T,B,H> & grid, Processor & processor)
     {
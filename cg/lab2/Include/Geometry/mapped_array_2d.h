@@ -1,6 +1,6 @@
 #pragma once
 
-#include "streams\structured_types.h"
+#include "Geometry\mapped_ptr.h"
 
 namespace cg
 {
@@ -73,10 +73,4 @@ namespace cg
       __forceinline point_2i index(const_iterator p) const 
       { return to2D(int(p - begin())); }
    };
-
-   template<class Stream, class T>
-      void read ( streams::structured_istream<Stream>& stream, mapped_array_2d<T>& p )
-   {
-      read ( stream, static_cast<ofs_ptr_s&>(p) ) ; 
-   }
 }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "common\safe_bool.h"
+
+// Self-relative pointers for memory-mapped images.
+//
+// The offset is counted from the address of the pointer itself, so an image made of
+// such pointers can be mapped at any address and shared between processes as is.
+// Offsets are 64-bit in the image whatever the platform, 0 is NULL.
+
+namespace cg
+{
+#pragma pack ( push , 1 )
+   struct ofs_ptr_s
+   {
+      ofs_ptr_s() : ofs_(0) {}
+
+      // copies point to the same place
+      ofs_ptr_s(ofs_ptr_s const & other) : ofs_(0)   { set_ptr(other.ptr()); }
+      ofs_ptr_s & operator = (ofs_ptr_s const & other) { set_ptr(other.ptr()); return *this; }
+
+      __forceinline char const * ptr() const
+      {
+         return ofs_ ? reinterpret_cast<char const *>(this) + ofs_ : NULL;
+      }
+
+      __forceinline void set_ptr(void const * p)
+      {
+         ofs_ = p ? static_cast<char const *>(p) - reinterpret_cast<char const *>(this) : 0;
+      }
+
+      // raw offset, for checking an image before following the pointer
+      __forceinline __int64 offset() const { return ofs_; }
+
+   private:
+      __int64 ofs_;
+   };
+
+   template <class T>
+      struct mapped_ptr : ofs_ptr_s
+   {
+      typedef T value_type;
+
+      mapped_ptr() {}
+      mapped_ptr(T const * p) { set_ptr(p); }
+
+      mapped_ptr & operator = (T const * p) { set_ptr(p); return *this; }
+
+      __forceinline T const * get        () const { return reinterpret_cast<T const *>(ptr()); }
+      __forceinline T const * operator ->() const { return get(); }
+      __forceinline T const & operator * () const { return *get(); }
+
+      SAFE_BOOL_OPERATOR(get())
+   };
+#pragma pack ( pop )
+}
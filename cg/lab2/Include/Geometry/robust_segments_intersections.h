@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <vector>
+
+#include "common/omp_utils.h"
+
 #include "Geometry/grid2L.h"
 #include "Geometry/Grid2L/subdiv.h"
 #include "Contours/misc/smallcell.h"
 
-#include "Geometry/cgal_predicates.h"
+#include "Geometry/default_predicates.h"
 
 namespace cg {
 namespace details {
@@ -41,44 +46,51 @@ private:
 };
 
 //////////////////////////////////////////////////////////////////////////
-template< class segment_id_type >
-   struct remove_processor
+// Subdivided segments are not removed from the cells right away, a cell drops them
+// before it is processed. The segment having children is the membership test.
+template< class segments_type >
+   struct is_subdivided
 {
-   typedef remove_processor BigCellProcessor;
-   typedef remove_processor SmallCellProcessor;
-
-   remove_processor( segment_id_type seg_id )
-      : seg_id_ (seg_id)
+   explicit is_subdivided( segments_type const &segments )
+      : segments_ (&segments)
    {
    }
 
-   template< class state, class small_cell_type >
-      bool operator () ( state const &, small_cell_type &cell )
+   template< class segment_id_type >
+      bool operator () ( segment_id_type id ) const
    {
-      small_cell_type::segments_type::iterator place =
-         std::find(cell.processed().begin(), cell.processed().end(), seg_id_);
-
-      if (place != cell.processed().end())
-         cell.processed().erase(place);
-
-      place = std::find(cell.to_process().begin(), cell.to_process().end(), seg_id_);
+      return (*segments_)[id].left != static_cast< segment_id_type >(-1);
+   }
 
-      if (place != cell.to_process().end())
-         cell.to_process().erase(place);
+private:
+   segments_type const *segments_;
+};
 
-      return false;
+//////////////////////////////////////////////////////////////////////////
+// Intersection found in parallel mode, subdivision is done after the pass
+template< class intr_type, class point_type >
+   struct deferred_intersection
+{
+   deferred_intersection( intr_type const &intr, point_type const &split, bool a_vertex, bool b_vertex, bool touch )
+      : intr (intr), split (split), a_vertex (a_vertex), b_vertex (b_vertex), touch (touch)
+   {
    }
 
-   BigCellProcessor & processgrid( ) { return *this; }
+   // by pair, then by point
+   bool operator < ( deferred_intersection const &other ) const
+   {
+      return intr < other.intr;
+   }
 
-   template< class State, class bigcell_type >
-      SmallCellProcessor &processbigcell( State const &, bigcell_type const & )
+   bool same_pair( deferred_intersection const &other ) const
    {
-      return *this;
+      return intr.idA() == other.intr.idA() && intr.idB() == other.intr.idB();
    }
 
-private:
-   segment_id_type seg_id_;
+   intr_type   intr;
+   point_type  split;     // where to subdivide
+   bool        a_vertex, b_vertex;  // split is an end of intr.idA(), intr.idB()
+   bool        touch;     // at the ends of both, nothing to subdivide
 };
 
 inline cg::point_2 const &min( cg::point_2 const &a, cg::point_2 const &b )
@@ -103,7 +115,7 @@ inline bool operator < ( cg::segment_2 const &a, cg::segment_2 const &b )
 }
 
 //////////////////////////////////////////////////////////////////////////
-template< class Host, class segments_type, class intr_type, class out_iter >
+template< class Host, class segments_type, class intr_type, class out_iter, class Predicates >
    struct intersect_processor
 {
    typedef typename segments_type::value_type segment_type;
@@ -121,11 +133,15 @@ template< class Host, class segments_type, class intr_type, class out_iter >
    {
    }
 
+   typedef deferred_intersection< intr_type, point_type > deferred_type;
+
    template< class state, class small_cell_type >
       bool operator () ( state const &st, small_cell_type &cell )
    {
       typedef typename small_cell_type::segment_id_type segment_id_type;
 
+      drop_subdivided(cell);
+
       cell.processed().reserve(cell.processed().size() + cell.to_process().size());
       for (int i = cell.to_process().size() - 1; i >= 0; --i)
       {
@@ -136,59 +152,30 @@ template< class Host, class segments_type, class intr_type, class out_iter >
          {
             segment_id_type idB = cell.processed()[j];
 
-            segment_type::input_segment_type segA = segments_.at(idA).seg;
-            segment_type::input_segment_type segB = segments_.at(idB).seg;
-            if (!(segA.P0() < segA.P1()))
-               segA = segment_type::input_segment_type (segA.P1(), segA.P0());
-            if (!(segB.P0() < segB.P1()))
-               segB = segment_type::input_segment_type (segB.P1(), segB.P0());
-
-            point_type ipA, ipB;
-            cg::intersection_type ires =
-               cg::robust_isect_segments(segA, segB, ipA, ipB);
-
-            if ((ires == cg::intersect || ires == cg::overlap) &&
-                (cg::distance(ipA, segA) > eps_ || cg::distance(ipA, segB) > eps_) ||
-                (ires == cg::overlap &&
-                (cg::distance(ipB, segA) > eps_ || cg::distance(ipB, segB) > eps_)))
-            {
-               ires = cg::exact_isect_segments(segA, segB, ipA, ipB);
-            }
+            pair_intersection res;
+            if (!intersect(idA, idB, res))
+               continue;
+
+            intr_type intr (idA, idB, res.p, res.type);
+            *output_++ = intr;
 
-            if (ires != cg::disjoint)
+            if (res.touch)
             {
-               intr_type intr (idA, idB, ipA, ires);
-               *output_++ = intr;
-
-               bool a_vertex_intersection = ipA == segA.P0() || ipA == segA.P1();
-               bool b_vertex_intersection = ipA == segB.P0() || ipA == segB.P1();
-
-               if (a_vertex_intersection && b_vertex_intersection && ires == cg::overlap)
-               {
-                  ipA = ipB;
-                  a_vertex_intersection = ipA == segA.P0() || ipA == segA.P1();
-                  b_vertex_intersection = ipA == segB.P0() || ipA == segB.P1();
-               }
-
-               if (a_vertex_intersection && b_vertex_intersection &&
-                   (ires != cg::overlap || segA == segB))
-               {
-                  if (host_.vertex_intersections_)
-                     host_.yield_intersection(intr);
-                  continue;
-               }
-
-               host_.yield_intersection(intr);
-               if (!a_vertex_intersection)
-                  subdiv_segment(idA, ipA);
-               else
-                  cell.to_process().push_back(idA);
-
-               if (!b_vertex_intersection)
-                  subdiv_segment(idB, ipA);
-
-               return operator ()(st, cell);
+               if (host_.vertex_intersections_)
+                  host_.yield_intersection(intr);
+               continue;
             }
+
+            host_.yield_intersection(intr);
+            if (!res.a_vertex)
+               subdiv_segment(idA, res.split);
+            else
+               cell.to_process().push_back(idA);
+
+            if (!res.b_vertex)
+               subdiv_segment(idB, res.split);
+
+            return operator ()(st, cell);
          }
 
          cell.processed().push_back(idA);
@@ -197,14 +184,43 @@ template< class Host, class segments_type, class intr_type, class out_iter >
       return false;
    }
 
+   // The same pairs as operator (), but nothing is subdivided: the intersections go to found.
+   // Touches only the cell, so cells are processed concurrently
+   template< class small_cell_type >
+      void collect( small_cell_type &cell, std::vector< deferred_type > &found ) const
+   {
+      typedef typename small_cell_type::segment_id_type segment_id_type;
+
+      drop_subdivided(cell);
+
+      cell.processed().reserve(cell.processed().size() + cell.to_process().size());
+      for (int i = cell.to_process().size() - 1; i >= 0; --i)
+      {
+         segment_id_type idA = cell.to_process()[i];
+         cell.to_process().pop_back();
+
+         for (size_t j = 0; j < cell.processed().size(); ++j)
+         {
+            segment_id_type idB = cell.processed()[j];
+
+            pair_intersection res;
+            if (intersect(idA, idB, res))
+            {
+               // intr_type puts the smaller id first
+               bool const swapped = idB < idA;
+               found.push_back(deferred_type (intr_type (idA, idB, res.p, res.type), res.split,
+                  swapped ? res.b_vertex : res.a_vertex, swapped ? res.a_vertex : res.b_vertex, res.touch));
+            }
+         }
+
+         cell.processed().push_back(idA);
+      }
+   }
+
    template< class segment_id_type >
       void subdiv_segment( segment_id_type segId, point_type const &p )
    {
-      // Remove from grid segments to subdivide
-      details::remove_processor< segment_id_type > rem_proc (segId);
-      cg::visit(*host_.grid_, host_.holder_[segId].seg, rem_proc);
-
-      // Subdivide
+      // Subdivide, the cells drop segId when processed (see is_subdivided)
       host_.holder_.push_back(segment_type (
          segment_type::input_segment_type (host_.holder_[segId].seg.P0(), p),
          host_.holder_[segId].root_ancestor));
@@ -234,6 +250,76 @@ template< class Host, class segments_type, class intr_type, class out_iter >
       return *this;
    }
 
+private:
+   struct pair_intersection
+   {
+      point_type        p;        // reported
+      point_type        split;    // where to subdivide
+      intersection_type type;
+      bool              a_vertex, b_vertex;
+      bool              touch;
+   };
+
+   template< class small_cell_type >
+      void drop_subdivided( small_cell_type &cell ) const
+   {
+      is_subdivided< segments_type > subdivided (segments_);
+
+      cell.processed().erase(std::remove_if(cell.processed().begin(), cell.processed().end(), subdivided),
+                             cell.processed().end());
+      cell.to_process().erase(std::remove_if(cell.to_process().begin(), cell.to_process().end(), subdivided),
+                              cell.to_process().end());
+   }
+
+   template< class segment_id_type >
+      bool intersect( segment_id_type idA, segment_id_type idB, pair_intersection &res ) const
+   {
+      typedef typename segment_type::input_segment_type input_segment_type;
+
+      input_segment_type segA = segments_.at(idA).seg;
+      input_segment_type segB = segments_.at(idB).seg;
+      if (!(segA.P0() < segA.P1()))
+         segA = input_segment_type (segA.P1(), segA.P0());
+      if (!(segB.P0() < segB.P1()))
+         segB = input_segment_type (segB.P1(), segB.P0());
+
+      point_type ipA, ipB;
+      cg::intersection_type ires =
+         Predicates::isect_segments(segA, segB, ipA, ipB);
+
+      if ((ires == cg::intersect || ires == cg::overlap) &&
+          (cg::distance(ipA, segA) > eps_ || cg::distance(ipA, segB) > eps_) ||
+          (ires == cg::overlap &&
+          (cg::distance(ipB, segA) > eps_ || cg::distance(ipB, segB) > eps_)))
+      {
+         ires = Predicates::exact_isect_segments(segA, segB, ipA, ipB);
+      }
+
+      if (ires == cg::disjoint)
+         return false;
+
+      res.p = ipA;
+      res.type = ires;
+
+      bool a_vertex_intersection = ipA == segA.P0() || ipA == segA.P1();
+      bool b_vertex_intersection = ipA == segB.P0() || ipA == segB.P1();
+
+      if (a_vertex_intersection && b_vertex_intersection && ires == cg::overlap)
+      {
+         ipA = ipB;
+         a_vertex_intersection = ipA == segA.P0() || ipA == segA.P1();
+         b_vertex_intersection = ipA == segB.P0() || ipA == segB.P1();
+      }
+
+      res.split = ipA;
+      res.a_vertex = a_vertex_intersection;
+      res.b_vertex = b_vertex_intersection;
+      res.touch = a_vertex_intersection && b_vertex_intersection &&
+                  (ires != cg::overlap || segA == segB);
+
+      return true;
+   }
+
 private:
    Host &host_;
    segments_type const &segments_;
@@ -346,7 +432,16 @@ struct EmptyFilter
 };
 
 //////////////////////////////////////////////////////////////////////////
-template< class input_segment_type, class input_segments_type = std::vector< input_segment_type >, class EdgeFilter = EmptyFilter >
+// Predicates: cgal_predicates or adaptive_predicates (default_predicates.h)
+//
+// With parallel = true every pass of the search processes the big cells of the grid concurrently.
+// A cell only collects the intersections of its segments, the segments are subdivided after
+// the pass, each at one point, and the pieces are checked by the next pass.
+// For segments in general position the intersections reported are the same. Where collinear
+// segments overlap the serial mode may miss pairs already split by an earlier one, the
+// parallel mode sees all segments of a pass whole and reports them too.
+template< class input_segment_type, class input_segments_type = std::vector< input_segment_type >, class EdgeFilter = EmptyFilter,
+          class Predicates = default_predicates >
    struct robust_segments_intersector
       : public std::vector< segments_intersection< size_t, typename input_segment_type::point_type > >
 {
@@ -396,7 +491,7 @@ public:
       details::intersect_processor
       <
          robust_segments_intersector, segments_type,
-         value_type, std::back_insert_iterator< base_type >
+         value_type, std::back_insert_iterator< base_type >, Predicates
       >
       inter_proc;
 
@@ -404,8 +499,11 @@ public:
 
 public:
    robust_segments_intersector( input_segments_type const &segments,
-                                bool vertex_intersections = false, scalar_type eps = 1e-5, EdgeFilter const & edge_filter = EdgeFilter() )
+                                bool vertex_intersections = false, scalar_type eps = 1e-5, EdgeFilter const & edge_filter = EdgeFilter(),
+                                bool parallel = false )
       : vertex_intersections_ (vertex_intersections)
+      , parallel_ (parallel)
+      , edge_filter_ (edge_filter)
    {
       for (input_segments_type::const_iterator it = segments.begin(); it != segments.end(); ++it)
          holder_.push_back(segment_type (*it, holder_.size()));
@@ -417,15 +515,18 @@ public:
 
    template< typename FwdIter >
       robust_segments_intersector( FwdIter p, FwdIter q,
-                                   bool vertex_intersections = false, scalar_type eps = 1e-5, EdgeFilter const & edge_filter = EdgeFilter()  )
-                                   :   edge_filter_ (edge_filter)
+                                   bool vertex_intersections = false, scalar_type eps = 1e-5, EdgeFilter const & edge_filter = EdgeFilter(),
+                                   bool parallel = false )
+                                   :   vertex_intersections_ (vertex_intersections)
+                                   ,   parallel_ (parallel)
+                                   ,   edge_filter_ (edge_filter)
    {
       for (FwdIter it = p; it != q; ++it)
          holder_.push_back(segment_type (*it, holder_.size()));
       segments_ = &holder_;
 
       unite_equal_segments();
-      find_intersections(vertex_intersections, eps);
+      find_intersections(eps);
    }
 
    segments_type const &holder() const
@@ -522,7 +623,10 @@ private:
       {
          base_type intersections;
          inter_proc proc (*this, *segments_, std::back_inserter(intersections), eps);
-         cg::visit_every_cell(*grid_, proc);
+         if (parallel_)
+            intersect_parallel(proc, intersections);
+         else
+            cg::visit_every_cell(*grid_, proc);
 
          vertex_intersections_ = false;
          num_intersected = intersections.size();
@@ -535,12 +639,92 @@ private:
       erase(std::unique(begin(), end()), end());
    }
 
+   // One pass of the parallel mode
+   void intersect_parallel( inter_proc &proc, base_type &intersections )
+   {
+      typedef typename inter_proc::deferred_type           deferred_type;
+      typedef typename grid_type::bigcell_type             bigcell_type;
+
+      // 1. cells, concurrently
+      std::vector< deferred_type > found;
+
+      int const bigs = (int)grid_->size();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+      {
+         std::vector< deferred_type > local;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16) nowait
+#endif
+         for (int b = 0; b < bigs; ++b)
+         {
+            bigcell_type &bigcell = (*grid_)[grid_->to2D(b)];
+            if (!bigcell)
+               continue;
+
+            for (typename bigcell_type::iterator it = bigcell.begin(); it != bigcell.end(); ++it)
+               proc.collect(*it, local);
+         }
+
+#ifdef _OPENMP
+#pragma omp critical (robust_segments_intersector_found)
+#endif
+         found.insert(found.end(), local.begin(), local.end());
+      }
+
+      // 2. a pair crossing several cells is found in each of them.
+      // A segment is cut once per pass, its other pairs are found again on the pieces, as the
+      // serial mode does. Cut at all points at once, nearly collinear segments get slivers
+      // between close points, and those cross the neighbours anew pass after pass
+      std::sort(found.begin(), found.end());
+
+      std::vector< char > cut (holder_.size(), 0);
+      std::vector< std::pair< segment_id_type, point_type > > splits;
+      for (size_t i = 0; i != found.size(); ++i)
+      {
+         deferred_type const &f = found[i];
+         if (i != 0 && f.same_pair(found[i - 1]))
+            continue;
+
+         intersections.push_back(f.intr);
+
+         if (f.touch)
+         {
+            if (vertex_intersections_)
+               yield_intersection(f.intr);
+            continue;
+         }
+
+         if (cut[f.intr.idA()] || cut[f.intr.idB()])
+            continue;
+
+         yield_intersection(f.intr);
+         if (!f.a_vertex)
+         {
+            cut[f.intr.idA()] = 1;
+            splits.push_back(std::make_pair(f.intr.idA(), f.split));
+         }
+         if (!f.b_vertex)
+         {
+            cut[f.intr.idB()] = 1;
+            splits.push_back(std::make_pair(f.intr.idB(), f.split));
+         }
+      }
+
+      // 3. subdivision
+      for (size_t i = 0; i != splits.size(); ++i)
+         proc.subdiv_segment(splits[i].first, splits[i].second);
+   }
+
 private:
    typedef details::segments_holder< segment_id_type > small_cell_type;
    typedef cg::Grid2L< small_cell_type >               grid_type;
 
 private:
    bool vertex_intersections_;
+   bool parallel_;
    segments_type const *segments_;
    EdgeFilter  edge_filter_;
 
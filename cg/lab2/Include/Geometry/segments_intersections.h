@@ -3,6 +3,7 @@
 #include "geometry\grid2l.h"
 #include "geometry\grid2l\subdiv.h"
 #include "contours\misc\smallcell.h"
+#include "geometry\default_predicates.h"
 
 namespace cg {
 
@@ -62,7 +63,7 @@ namespace cg {
          intersection_type type_;
       };
 
-      template < typename segments_type, typename intr_type, typename OutIter >
+      template < typename segments_type, typename intr_type, typename OutIter, class Predicates >
          struct IntersectionsProcessor
       {
          typedef typename segments_type::value_type   segment_type;
@@ -144,7 +145,7 @@ namespace cg {
                   else
                   {
                      point_type a, b;
-                     const intersection_type intr = cg::robust_isect_segments( seg1, seg2, a, b );
+                     const intersection_type intr = Predicates::isect_segments( seg1, seg2, a, b );
                      if( intr == cg::intersect )
                         *output_++ = intr_type( id1, id2, a, intr );   
                      else if( intr == cg::overlap )
@@ -204,7 +205,8 @@ namespace cg {
       cg::visit_every_cell( RasterizedSegments< segments_type >( segments ).grid( ), proc );
    }
 
-   template< typename segment_type, typename segments_type = std::vector< segment_type > >
+   // Predicates: cgal_predicates or adaptive_predicates (default_predicates.h)
+   template< typename segment_type, typename segments_type = std::vector< segment_type >, class Predicates = default_predicates >
       struct SegmentsIntersections
    {
    private:
@@ -270,7 +272,7 @@ namespace cg {
       {
          // FIXME: Segments must be rasterized with eps_ neighbourhood, otherwise
          // epsilon-intersections on cell edge will be missed.
-         details::IntersectionsProcessor< segments_type, intr_type, std::back_insert_iterator< intersections_type > >
+         details::IntersectionsProcessor< segments_type, intr_type, std::back_insert_iterator< intersections_type >, Predicates >
             proc( *segments_, std::back_inserter( intersections_ ), eps_ );
          rasterize_segments( *segments_, proc );  
 
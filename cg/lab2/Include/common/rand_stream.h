@@ -0,0 +1,108 @@
+#pragma once
+
+#include <emmintrin.h>
+
+#include <boost/cstdint.hpp>
+
+// Reproducible random streams for parallel Monte-Carlo code.
+//
+// Four xoshiro128+ generators (Blackman, Vigna) run side by side in the lanes of an SSE register,
+// so numbers come four at a time. A stream is keyed, not shared: the state is hashed from
+// (seed, key1, key2) with splitmix64, so e.g. keying by pixel and sample index makes a parallel
+// render come out the same whatever thread traces what. Unlike rand() there is no global
+// state and no lock, each thread simply owns the streams it creates.
+// xoshiro128+ has weak low bits, floats are taken from the high ones.
+
+struct rand_stream
+{
+   explicit rand_stream(boost::uint64_t seed = 0, boost::uint64_t key1 = 0, boost::uint64_t key2 = 0)
+      : used_(4)
+   {
+      boost::uint64_t x = mix(mix(seed) ^ key1);
+      x = mix(x ^ mix(key2));
+
+      unsigned s[16];
+      for (size_t i = 0; i != 16; i += 2)
+      {
+         boost::uint64_t const v = splitmix64(x);
+         s[i    ] = (unsigned)v;
+         s[i + 1] = (unsigned)(v >> 32);
+      }
+
+      // an all-zero lane would stay zero forever
+      for (size_t lane = 0; lane != 4; ++lane)
+         if ((s[lane] | s[lane + 4] | s[lane + 8] | s[lane + 12]) == 0)
+            s[lane] = 1;
+
+      s0_ = _mm_setr_epi32(s[0], s[1], s[2], s[3]);
+      s1_ = _mm_setr_epi32(s[4], s[5], s[6], s[7]);
+      s2_ = _mm_setr_epi32(s[8], s[9], s[10], s[11]);
+      s3_ = _mm_setr_epi32(s[12], s[13], s[14], s[15]);
+   }
+
+   // 4 x 32 random bits
+   __m128i next4()
+   {
+      __m128i const res = _mm_add_epi32(s0_, s3_);
+      __m128i const t   = _mm_slli_epi32(s1_, 9);
+
+      s2_ = _mm_xor_si128(s2_, s0_);
+      s3_ = _mm_xor_si128(s3_, s1_);
+      s1_ = _mm_xor_si128(s1_, s2_);
+      s0_ = _mm_xor_si128(s0_, s3_);
+      s2_ = _mm_xor_si128(s2_, t);
+      s3_ = _mm_or_si128(_mm_slli_epi32(s3_, 11), _mm_srli_epi32(s3_, 21));
+
+      return res;
+   }
+
+   // 4 floats uniform in [0, 1)
+   __m128 uniform4()
+   {
+      // top 23 bits as the mantissa of a float in [1, 2)
+      __m128i const bits = _mm_or_si128(_mm_srli_epi32(next4(), 9), _mm_set1_epi32(0x3f800000));
+      return _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.f));
+   }
+
+   // n floats uniform in [0, 1)
+   void uniform(float * dst, size_t n)
+   {
+      size_t i = 0;
+      for (; i + 4 <= n; i += 4)
+         _mm_storeu_ps(dst + i, uniform4());
+
+      for (; i != n; ++i)
+         dst[i] = uniform();
+   }
+
+   // one float uniform in [0, 1)
+   float uniform()
+   {
+      if (used_ == 4)
+      {
+         _mm_storeu_ps(buf_, uniform4());
+         used_ = 0;
+      }
+      return buf_[used_++];
+   }
+
+private:
+   static boost::uint64_t splitmix64(boost::uint64_t & x)
+   {
+      x += 0x9E3779B97F4A7C15ull;
+      return mix(x);
+   }
+
+   // splitmix64 finalizer
+   static boost::uint64_t mix(boost::uint64_t z)
+   {
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+   }
+
+private:
+   __m128i s0_, s1_, s2_, s3_;
+   float   buf_[4];
+   int     used_;
+};
@@ -31,6 +31,9 @@ int APIENTRY _tWinMain(HINSTANCE hInstance,
 	UNREFERENCED_PARAMETER(hPrevInstance);
 	UNREFERENCED_PARAMETER(lpCmdLine);
 
+	// material colors are random, a new run shows a new palette
+	::srand(GetTickCount());
+
  	// TODO: Place code here.
 	MSG msg;
 	HACCEL hAccelTable;
@@ -127,31 +130,16 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
    return TRUE;
 }
 
-static HDC _hdc = NULL;
-static HBITMAP _hbitmap = NULL;
-
 static void create_buffer(HWND hwnd)
 {
    end_drawing();
 
-   if (_hbitmap)
-      DeleteObject(_hbitmap);
-   if (_hdc)
-      DeleteDC(_hdc);
-
    RECT r;
    GetClientRect(hwnd, &r);
 
    _width = r.right - r.left;
    _height = r.bottom - r.top;
 
-   HDC hdc = GetDC(hwnd);
-      _hdc = CreateCompatibleDC(hdc );
-      _hbitmap = CreateCompatibleBitmap(hdc, _width, _height);
-   ReleaseDC(hwnd, hdc);
-   HANDLE holdbitmap = (HBITMAP)SelectObject(_hdc, _hbitmap);
-   DeleteObject(holdbitmap);
-
    start_drawing();
 }
 
@@ -169,23 +157,22 @@ VOID CALLBACK draw_timer_proc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTi
 
 struct render_data
 {
-   bool is_alive;
-   int win_w;
-   int win_h;
-   HDC dc;
-   boost::scoped_ptr<lock::critsec> cs;
+   render_data() : is_alive(false), mode(render_progressive) {}
 
-   render_data()
-      : cs(new lock::critsec())
-   {
-   }
+   bool is_alive;
+   render_mode mode; // F6 cycles through the modes
+   progressive_task prog;
+   framebuffer fb;
 };
 static render_data rd;
 
 DWORD WINAPI thread_fun(LPVOID data)
 {
    render_data * rd = (render_data *)data;
-   render(rd->win_w, rd->win_h, rd->dc, &rd->is_alive, rd->cs.get());
+   if (rd->mode == render_progressive)
+      rd->prog.render(rd->fb, &rd->is_alive);
+   else
+      render(rd->fb, &rd->is_alive, rd->mode);
    return 0;
 }
 
@@ -195,10 +182,9 @@ static int num_threads = 0;
 void start_drawing()
 {
    end_drawing();
-   rd.win_w = _width;
-   rd.win_h = _height;
+   rd.fb.resize(_width, _height);
+   rd.fb.clear(cg::color_white());
    rd.is_alive = true;
-   rd.dc = _hdc;
 
    hthread = CreateThread(NULL, 0, thread_fun, (LPVOID)&rd, 0, NULL);
    num_threads++;
@@ -250,9 +236,22 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
       {
 		   hdc = BeginPaint(hWnd, &ps);
 
-         rd.cs->lock();
-         BOOL res = BitBlt(hdc, 0, 0, _width, _height, _hdc, 0, 0, SRCCOPY);
-         rd.cs->unlock();
+         // the render thread keeps writing meanwhile, a torn pixel is just redrawn next tick
+         static std::vector<unsigned> pixels;
+         rd.fb.to_rgbx(pixels);
+         if (!pixels.empty())
+         {
+            BITMAPINFO bi = {};
+            bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+            bi.bmiHeader.biWidth = rd.fb.width();
+            bi.bmiHeader.biHeight = -rd.fb.height(); // top-down rows
+            bi.bmiHeader.biPlanes = 1;
+            bi.bmiHeader.biBitCount = 32;
+            bi.bmiHeader.biCompression = BI_RGB;
+
+            SetDIBitsToDevice(hdc, 0, 0, rd.fb.width(), rd.fb.height(), 0, 0, 0, rd.fb.height(), 
+               &pixels[0], &bi, DIB_RGB_COLORS);
+         }
 
 		   EndPaint(hWnd, &ps);
       }
@@ -268,7 +267,18 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
       break;
    case WM_KEYUP:
       if (wParam == VK_F5)
+      {
+         end_drawing();
+         rd.prog.reset();
+         create_buffer(hWnd);
+      }
+      else if (wParam == VK_F6)
+      {
+         end_drawing();
+         rd.mode = (render_mode)((rd.mode + 1) % (render_progressive + 1));
+         rd.prog.reset();
          create_buffer(hWnd);
+      }
       break;
 	default:
 		return DefWindowProc(hWnd, message, wParam, lParam);
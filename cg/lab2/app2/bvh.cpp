@@ -0,0 +1,364 @@
+#include "stdafx.h"
+
+#include "bvh.h"
+
+namespace
+{
+   const int bins_count    = 12;
+   const int max_leaf_size = 4;
+   const int max_depth     = 60;
+
+   // sah cost of a leaf item relative to one node traversal
+   const double isect_cost = 1.5;
+
+   double area( rectangle_3 const & r )
+   {
+      point_3 const s = r.size();
+      return 2 * (s.x * s.y + s.y * s.z + s.z * s.x);
+   }
+
+   // slab test, tnear is the entry parameter along dir
+   bool hit_box( point_3 const & lo, point_3 const & hi, point_3 const & org, point_3 const & inv, double tmax, double & tnear )
+   {
+      double t0 = 0, t1 = tmax;
+      for (size_t i = 0; i != 3; ++i)
+      {
+         double ta = (lo[i] - org[i]) * inv[i];
+         double tb = (hi[i] - org[i]) * inv[i];
+         if (ta > tb)
+            std::swap(ta, tb);
+
+         // written so that NaN (ray in the slab plane) leaves the interval as is
+         t0 = ta > t0 ? ta : t0;
+         t1 = tb < t1 ? tb : t1;
+         if (t0 > t1)
+            return false;
+      }
+
+      tnear = t0;
+      return true;
+   }
+
+   point_3 inverse( point_3 const & d )
+   {
+      return point_3(1. / d.x, 1. / d.y, 1. / d.z);
+   }
+}
+
+struct scene_bvh::build_item
+{
+   rectangle_3 bound;
+   point_3     center;
+   prim_ref    prim;
+};
+
+namespace
+{
+   struct center_less
+   {
+      explicit center_less(size_t axis) : axis_(axis) {}
+
+      template <class Item>
+      bool operator () (Item const & a, Item const & b) const
+      {
+         return a.center[axis_] < b.center[axis_];
+      }
+
+   private:
+      size_t axis_;
+   };
+}
+
+scene_bvh::scene_bvh()
+   : scene_(NULL)
+{
+}
+
+scene_bvh::scene_bvh( scene const & sc )
+{
+   build(sc);
+}
+
+void scene_bvh::build( scene const & sc )
+{
+   scene_ = &sc;
+   nodes_.clear();
+   items_.clear();
+   unbounded_.clear();
+
+   std::vector<prim_ref> prims;
+   sc.refs(prims);
+
+   std::vector<build_item> items;
+   items.reserve(prims.size());
+   for (size_t i = 0; i != prims.size(); ++i)
+   {
+      optional<rectangle_3> bound = sc.bounds(prims[i]);
+      if (!bound)
+      {
+         unbounded_.push_back(prims[i]);
+         continue;
+      }
+
+      build_item item;
+      item.bound  = *bound;
+      item.center = bound->center();
+      item.prim   = prims[i];
+      items.push_back(item);
+   }
+
+   if (items.empty())
+      return;
+
+   nodes_.reserve(2 * items.size());
+   nodes_.push_back(node());
+   build_node(items, 0, 0, (int)items.size(), 0);
+
+   items_.reserve(items.size());
+   for (size_t i = 0; i != items.size(); ++i)
+      items_.push_back(items[i].prim);
+}
+
+void scene_bvh::build_node( std::vector<build_item> & items, int idx, int begin, int end, int depth )
+{
+   rectangle_3 bound, centers;
+   for (int i = begin; i != end; ++i)
+   {
+      bound   |= items[i].bound;
+      centers |= items[i].center;
+   }
+
+   nodes_[idx].lo = bound.lo();
+   nodes_[idx].hi = bound.hi();
+
+   int const count = end - begin;
+
+   size_t axis = 0;
+   point_3 const extent = centers.size();
+   if (extent[1] > extent[axis]) axis = 1;
+   if (extent[2] > extent[axis]) axis = 2;
+
+   bool const degenerate = cg::eq_zero(extent[axis]);
+
+   if (count <= 1 || depth >= max_depth || (degenerate && count <= max_leaf_size))
+   {
+      nodes_[idx].first = begin;
+      nodes_[idx].count = count;
+      return;
+   }
+
+   int mid = begin;
+   if (!degenerate)
+   {
+      // bin centers along the axis and sweep the bins for the cheapest split
+      double const lo = centers[axis].lo();
+      double const scale = bins_count / extent[axis];
+
+      int         bin_counts[bins_count] = {};
+      rectangle_3 bin_bounds[bins_count];
+
+      std::vector<int> bin_of(count);
+      for (int i = 0; i != count; ++i)
+      {
+         int b = cg::min((int)((items[begin + i].center[axis] - lo) * scale), bins_count - 1);
+         bin_of[i] = b;
+         bin_counts[b]++;
+         bin_bounds[b] |= items[begin + i].bound;
+      }
+
+      double right_area[bins_count];
+      int    right_count[bins_count];
+      rectangle_3 acc;
+      int n = 0;
+      for (int b = bins_count - 1; b > 0; --b)
+      {
+         acc |= bin_bounds[b];
+         n += bin_counts[b];
+         right_area[b] = area(acc);
+         right_count[b] = n;
+      }
+
+      int    best_split = -1;
+      double best_cost = std::numeric_limits<double>::max();
+      acc = rectangle_3();
+      n = 0;
+      for (int b = 0; b < bins_count - 1; ++b)
+      {
+         acc |= bin_bounds[b];
+         n += bin_counts[b];
+         if (n == 0 || right_count[b + 1] == 0)
+            continue;
+
+         double cost = area(acc) * n + right_area[b + 1] * right_count[b + 1];
+         if (cost < best_cost)
+         {
+            best_cost = cost;
+            best_split = b;
+         }
+      }
+
+      double const leaf_cost = area(bound) * count;
+      double const split_cost = area(bound) / isect_cost + best_cost;
+      if (count <= max_leaf_size && (best_split < 0 || split_cost >= leaf_cost))
+      {
+         nodes_[idx].first = begin;
+         nodes_[idx].count = count;
+         return;
+      }
+
+      if (best_split >= 0)
+      {
+         // stable two-way partition by bin
+         std::vector<build_item> right;
+         mid = begin;
+         for (int i = 0; i != count; ++i)
+         {
+            if (bin_of[i] <= best_split)
+               items[mid++] = items[begin + i];
+            else
+               right.push_back(items[begin + i]);
+         }
+         std::copy(right.begin(), right.end(), items.begin() + mid);
+      }
+   }
+
+   // all centers in one bin, fall back to the median split
+   if (mid == begin || mid == end)
+   {
+      mid = begin + count / 2;
+      std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, center_less(axis));
+   }
+
+   int const left = (int)nodes_.size();
+   nodes_.push_back(node());
+   nodes_.push_back(node());
+   nodes_[idx].first = left;
+   nodes_[idx].count = 0;
+
+   build_node(items, left    , begin, mid, depth + 1);
+   build_node(items, left + 1, mid  , end, depth + 1);
+}
+
+prim_ref scene_bvh::closest_hit( line_3 const & l, intersect_detail & detail ) const
+{
+   prim_ref res;
+   double best = std::numeric_limits<double>::max();
+
+   for (size_t i = 0; i != unbounded_.size(); ++i)
+   {
+      intersect_detail d;
+      if (scene_->intersect_ray(unbounded_[i], l, &d) && *d.t < best)
+      {
+         best = *d.t;
+         detail = d;
+         res = unbounded_[i];
+      }
+   }
+
+   if (nodes_.empty())
+      return res;
+
+   point_3 const & org = l.p();
+   point_3 const   inv = inverse(l.r());
+
+   // entries carry the box entry distance, so boxes behind a closer hit are dropped on pop
+   std::pair<int, double> stack[max_depth + 2];
+   int top = 0;
+
+   double tnear;
+   if (hit_box(nodes_[0].lo, nodes_[0].hi, org, inv, best, tnear))
+      stack[top++] = std::make_pair(0, tnear);
+
+   while (top)
+   {
+      std::pair<int, double> const entry = stack[--top];
+      if (entry.second > best)
+         continue;
+
+      node const & n = nodes_[entry.first];
+      if (n.count)
+      {
+         for (int i = n.first; i != n.first + n.count; ++i)
+         {
+            intersect_detail d;
+            if (scene_->intersect_ray(items_[i], l, &d) && *d.t < best)
+            {
+               best = *d.t;
+               detail = d;
+               res = items_[i];
+            }
+         }
+         continue;
+      }
+
+      double t0, t1;
+      bool const hit0 = hit_box(nodes_[n.first    ].lo, nodes_[n.first    ].hi, org, inv, best, t0);
+      bool const hit1 = hit_box(nodes_[n.first + 1].lo, nodes_[n.first + 1].hi, org, inv, best, t1);
+
+      // far child goes first to the stack, so the near one is popped first
+      if (hit0 && hit1)
+      {
+         if (t0 <= t1)
+         {
+            stack[top++] = std::make_pair(n.first + 1, t1);
+            stack[top++] = std::make_pair(n.first    , t0);
+         }
+         else
+         {
+            stack[top++] = std::make_pair(n.first    , t0);
+            stack[top++] = std::make_pair(n.first + 1, t1);
+         }
+      }
+      else if (hit0)
+         stack[top++] = std::make_pair(n.first, t0);
+      else if (hit1)
+         stack[top++] = std::make_pair(n.first + 1, t1);
+   }
+
+   return res;
+}
+
+bool scene_bvh::any_hit( segment_3 const & s, prim_ref skip ) const
+{
+   // a custom object (a mesh) may shadow itself, so it is tested anyway;
+   // its faces leave out hits at the very start of the segment as all triangles do
+   if (skip.kind == prim_ref::custom)
+      skip = prim_ref();
+
+   for (size_t i = 0; i != unbounded_.size(); ++i)
+      if (unbounded_[i] != skip && scene_->intersect_seg(unbounded_[i], s, NULL))
+         return true;
+
+   if (nodes_.empty())
+      return false;
+
+   // segment parameter runs over [0, 1]
+   point_3 const & org = s.P0();
+   point_3 const   inv = inverse(s.P1() - s.P0());
+
+   int stack[max_depth + 2];
+   int top = 0;
+   stack[top++] = 0;
+
+   while (top)
+   {
+      node const & n = nodes_[stack[--top]];
+
+      double tnear;
+      if (!hit_box(n.lo, n.hi, org, inv, 1., tnear))
+         continue;
+
+      if (n.count)
+      {
+         for (int i = n.first; i != n.first + n.count; ++i)
+            if (items_[i] != skip && scene_->intersect_seg(items_[i], s, NULL))
+               return true;
+         continue;
+      }
+
+      stack[top++] = n.first + 1;
+      stack[top++] = n.first;
+   }
+
+   return false;
+}
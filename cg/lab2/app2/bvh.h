@@ -0,0 +1,46 @@
+#pragma once
+
+#include "scene.h"
+
+// Bounding volume hierarchy over scene primitives, built top-down with binned SAH.
+// Primitives without finite bounds (planes) are kept aside and tested on every query.
+// The scene is referenced, not copied, and must outlive the hierarchy.
+// Queries are read-only and may run concurrently.
+struct scene_bvh
+{
+   scene_bvh();
+   explicit scene_bvh(scene const & sc);
+
+   void build(scene const & sc);
+
+   // closest primitive hit by the ray, invalid ref if none, detail describes the hit
+   prim_ref closest_hit(line_3 const & l, intersect_detail & detail) const;
+
+   // true as soon as any primitive other than skip crosses the segment,
+   // a custom skip is still tested: only a primitive can't shadow itself, a mesh can
+   bool any_hit(segment_3 const & s, prim_ref skip) const;
+
+   size_t nodes_count() const { return nodes_.size(); }
+
+private:
+   struct node
+   {
+      point_3 lo;
+      point_3 hi;
+
+      // inner node : children are nodes_[first] and nodes_[first + 1]
+      // leaf       : primitives are items_[first, first + count)
+      int first;
+      int count;
+   };
+
+   struct build_item;
+
+   void build_node(std::vector<build_item> & items, int idx, int begin, int end, int depth);
+
+private:
+   scene const *         scene_;
+   std::vector<node>     nodes_;
+   std::vector<prim_ref> items_;
+   std::vector<prim_ref> unbounded_;
+};
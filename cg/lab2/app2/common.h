@@ -1,4 +1,7 @@
 #pragma once 
 
 cg::colorf operator& (cg::colorf const & a, cg::colorf const & b);
-point_3 rand_vec(double norm = 1.0);
+struct rand_stream;
+
+// uniform over the sphere of radius norm
+point_3 rand_vec(rand_stream & rng, double norm = 1.0);
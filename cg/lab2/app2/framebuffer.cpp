@@ -0,0 +1,82 @@
+#include "stdafx.h"
+
+#include "framebuffer.h"
+
+framebuffer::framebuffer( int width, int height )
+   : width_(0)
+   , height_(0)
+{
+   resize(width, height);
+}
+
+void framebuffer::resize( int width, int height )
+{
+   width_ = cg::max(width, 0);
+   height_ = cg::max(height, 0);
+   data_.assign(width_ * height_, cg::color_black());
+}
+
+void framebuffer::clear( colorf const & color )
+{
+   std::fill(data_.begin(), data_.end(), color);
+}
+
+static unsigned to_byte( float v )
+{
+   return (unsigned)(cg::bound(v, 0.f, 1.f) * 255);
+}
+
+void framebuffer::to_rgbx( std::vector<unsigned> & dst ) const
+{
+   dst.resize(data_.size());
+   for (size_t i = 0; i < data_.size(); ++i)
+   {
+      colorf const & c = data_[i];
+      dst[i] = (to_byte(c.r) << 16) | (to_byte(c.g) << 8) | to_byte(c.b);
+   }
+}
+
+bool framebuffer::write_ppm( std::string const & path ) const
+{
+   std::ofstream out(path.c_str(), std::ios::binary);
+   out << "P6\n" << width_ << " " << height_ << "\n255\n";
+
+   std::vector<unsigned char> row(3 * width_);
+   for (int y = 0; y != height_; ++y)
+   {
+      for (int x = 0; x != width_; ++x)
+      {
+         colorf const & c = (*this)(x, y);
+         row[3 * x    ] = (unsigned char)to_byte(c.r);
+         row[3 * x + 1] = (unsigned char)to_byte(c.g);
+         row[3 * x + 2] = (unsigned char)to_byte(c.b);
+      }
+      if (width_)
+         out.write((char const *)&row[0], row.size());
+   }
+
+   return !!out;
+}
+
+bool framebuffer::write_pfm( std::string const & path ) const
+{
+   std::ofstream out(path.c_str(), std::ios::binary);
+   // negative scale means little-endian, rows go bottom-up
+   out << "PF\n" << width_ << " " << height_ << "\n-1.0\n";
+
+   std::vector<float> row(3 * width_);
+   for (int y = height_ - 1; y >= 0; --y)
+   {
+      for (int x = 0; x != width_; ++x)
+      {
+         colorf const & c = (*this)(x, y);
+         row[3 * x    ] = c.r;
+         row[3 * x + 1] = c.g;
+         row[3 * x + 2] = c.b;
+      }
+      if (width_)
+         out.write((char const *)&row[0], row.size() * sizeof(float));
+   }
+
+   return !!out;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// plain RGB float image, row-major, (0, 0) is the top-left pixel
+struct framebuffer
+{
+   framebuffer(int width = 0, int height = 0);
+
+   void resize(int width, int height);
+   void clear(colorf const & color = cg::color_black());
+
+   int width () const { return width_;  }
+   int height() const { return height_; }
+
+   colorf       & operator () (int x, int y)       { return data_[y * width_ + x]; }
+   colorf const & operator () (int x, int y) const { return data_[y * width_ + x]; }
+
+   // clamps colors to [0, 1] and packs them into top-down 32-bit 0x00RRGGBB rows
+   void to_rgbx(std::vector<unsigned> & dst) const;
+
+   // binary P6 ppm, clamped like to_rgbx
+   bool write_ppm(std::string const & path) const;
+   // little-endian pfm, raw floats
+   bool write_pfm(std::string const & path) const;
+
+private:
+   int width_;
+   int height_;
+   std::vector<colorf> data_;
+};
@@ -1,69 +1,86 @@
 #pragma once
 
-struct fuzzy_refl_calc
+#include "sampling.h"
+
+// Phong (cosine-power) lobe around the mirror direction.
+// Directions are drawn with density proportional to the lobe, so every
+// sample carries the same weight and none of them has to be rejected.
+struct glossy_lobe
 {
-   fuzzy_refl_calc(point_3 const & v, point_3 const & n)
-      : v(v)
-      , n(n)
+   glossy_lobe(point_3 const & refl, double exponent)
+      : w_(cg::normalized_safe(refl))
+      , exp_(exponent)
    {
+      make_basis(w_, u_, v_);
    }
 
-   double operator() (point_3 const & _l)
+   // u1, u2 uniform in [0, 1)
+   point_3 sample(double u1, double u2) const
    {
-      l = _l;
-      h = cg::normalized_safe(l + v);
-
-      double f = F();
-      double d = D();
-      double g = G();
+      double cos_t = pow(1 - u1, 1 / (exp_ + 1));
+      double sin_t = sqrt(cg::max(0., 1 - cos_t * cos_t));
+      double phi = 2 * cg::pi * u2;
 
-      return d;
-      return f * d * g / (n * l) / (n * v);
+      return (sin_t * cos(phi)) * u_ + (sin_t * sin(phi)) * v_ + cos_t * w_;
    }
 
-private:
-   double F()
+   // density of sample() over the sphere of directions
+   double pdf(point_3 const & dir) const
    {
-      return 1.;
-      //return 1. / pow((1. + (h * l)), 5);
-      //const double nu = 1.1;
+      double cs = dir * w_;
+      return cs > 0 ? (exp_ + 1) / (2 * cg::pi) * pow(cs, exp_) : 0;
+   }
 
-      //double c = h * l;
-      //double g = sqrt(nu * nu + c * c - 1);
+private:
+   point_3 w_;
+   point_3 u_;
+   point_3 v_;
+   double  exp_;
+};
 
-      //return 
-      //   0.5 * 
-      //   ((c - g) / (c + g)) *
-      //   (1 + cg::sqr((c * (c + g) - 1) / (c * (c - g) - 1)));
+// running mean and variance of sample luminance (Welford), 
+// tells when a Monte-Carlo estimate has settled
+struct sample_stats
+{
+   sample_stats()
+      : n_(0)
+      , sum_(cg::color_black())
+      , mean_(0)
+      , m2_(0)
+   {
    }
 
-   double D()
+   void add(colorf const & c)
    {
-      double a = cg::angle(n, h);
-      const double m = .01;
+      n_++;
+      sum_ += c;
 
-      if (cg::abs(a) < cg::pi / 3)
-         return 1;
-      else
-         return 0;
+      double y = 0.2126 * c.r + 0.7152 * c.g + 0.0722 * c.b;
+      double delta = y - mean_;
+      mean_ += delta / n_;
+      m2_ += delta * (y - mean_);
+   }
 
-      return 
-         1 / (4. * cg::pi * m*m * pow(n * h, 4.)) *
-         exp(-cg::sqr(tan((a)) / m));
+   int count() const { return n_; }
+
+   colorf mean() const 
+   { 
+      return n_ ? sum_ / (float)n_ : cg::color_black(); 
    }
 
-   double G()
+   // standard error of the mean is within rel_err of the mean, or below abs_err for dark samples
+   bool converged(double rel_err, double abs_err) const
    {
-      return cg::min(
-         1.,
-         2 * (n * h) * (n * v) / (v * h),
-         2 * (n * h) * (n * l) / (v * h)
-      );
+      if (n_ < 2)
+         return false;
+
+      double std_err = sqrt(m2_ / (n_ - 1) / n_);
+      return std_err <= cg::max(rel_err * cg::abs(mean_), abs_err);
    }
 
 private:
-   point_3 v;
-   point_3 n;
-   point_3 h;
-   point_3 l;
+   int    n_;
+   colorf sum_;
+   double mean_;
+   double m2_;
 };
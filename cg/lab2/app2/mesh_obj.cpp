@@ -0,0 +1,163 @@
+#include "stdafx.h"
+
+#include "mesh_obj.h"
+
+mesh_obj::mesh_obj( std::vector<point_3> const & verts, std::vector<cg::point_3i> const & faces )
+   : verts_(verts)
+   , normals_(verts.size())
+   , faces_(faces)
+{
+   material const m;
+   for (size_t i = 0; i != faces_.size(); ++i)
+   {
+      cg::point_3i const & f = faces_[i];
+      point_3 const & a = verts_[f.x];
+      point_3 const & b = verts_[f.y];
+      point_3 const & c = verts_[f.z];
+
+      tris_.add_triangle(a, b, c, m);
+
+      // cross product length is twice the area, so big faces weigh more
+      point_3 const n = (b - a) ^ (c - a);
+      normals_[f.x] += n;
+      normals_[f.y] += n;
+      normals_[f.z] += n;
+
+      bound_ |= a;
+      bound_ |= b;
+      bound_ |= c;
+   }
+
+   for (size_t i = 0; i != normals_.size(); ++i)
+      normals_[i] = cg::normalized_safe(normals_[i]);
+
+   bvh_.build(tris_);
+}
+
+bool mesh_obj::intersect_ray( line_3 const & l, intersect_detail * detail )
+{
+   intersect_detail d;
+   prim_ref const p = bvh_.closest_hit(l, d);
+   if (!p.valid())
+      return false;
+
+   if (detail)
+   {
+      smooth(p.idx, l.r(), d);
+      *detail = d;
+   }
+   return true;
+}
+
+bool mesh_obj::intersect_seg( segment_3 const & s, intersect_detail * detail )
+{
+   if (!detail)
+      return bvh_.any_hit(s, prim_ref());
+
+   // closest hit along the segment's line, then check that it lies within the segment
+   line_3 l(s.P0(), s.P1(), cg::line::by_points);
+   intersect_detail d;
+   prim_ref const p = bvh_.closest_hit(l, d);
+   if (!p.valid() || !cg::le(*d.t, cg::length(s)))
+      return false;
+
+   smooth(p.idx, direction(s), d);
+   *detail = d;
+   return true;
+}
+
+point_3 mesh_obj::normal( point_3 const & p )
+{
+   double best = std::numeric_limits<double>::max();
+   point_3 res;
+   std::vector<triangle_prim> const & tris = tris_.triangles();
+   for (size_t i = 0; i != tris.size(); ++i)
+   {
+      triangle_prim const & t = tris[i];
+      // distance to the face plane is enough for points that lie on the mesh
+      double const dist = cg::abs((p - t.a) * t.n);
+      if (dist < best)
+      {
+         best = dist;
+         res = t.n;
+      }
+   }
+   return res;
+}
+
+optional<rectangle_3> mesh_obj::bounds()
+{
+   return bound_;
+}
+
+void mesh_obj::smooth( int face, point_3 const & view, intersect_detail & d ) const
+{
+   triangle_prim const & t = tris_.triangles()[face];
+
+   // barycentrics of the hit point, see "Real-Time Collision Detection" 3.4
+   point_3 const e = d.pos - t.a;
+   double const d00 = t.e1 * t.e1;
+   double const d01 = t.e1 * t.e2;
+   double const d11 = t.e2 * t.e2;
+   double const d20 = e * t.e1;
+   double const d21 = e * t.e2;
+   double const den = d00 * d11 - d01 * d01;
+   if (cg::eq_zero(den))
+      return;
+
+   double const v = (d11 * d20 - d01 * d21) / den;
+   double const w = (d00 * d21 - d01 * d20) / den;
+
+   cg::point_3i const & f = faces_[face];
+   point_3 n = cg::normalized_safe(normals_[f.x] * (1 - v - w) + normals_[f.y] * v + normals_[f.z] * w);
+   if (n * view > 0)
+      n = -n;
+
+   d.n = n;
+   d.reflect = view - n * (2 * (view * n));
+}
+
+bool load_obj( std::string const & path, std::vector<point_3> & verts, std::vector<cg::point_3i> & faces )
+{
+   std::ifstream in(path.c_str());
+   if (!in)
+      return false;
+
+   verts.clear();
+   faces.clear();
+
+   std::string line;
+   while (std::getline(in, line))
+   {
+      std::istringstream ss(line);
+      std::string tag;
+      ss >> tag;
+
+      if (tag == "v")
+      {
+         point_3 v;
+         if (!(ss >> v.x >> v.y >> v.z))
+            return false;
+         verts.push_back(v);
+      }
+      else if (tag == "f")
+      {
+         // "i", "i/t", "i//n" or "i/t/n", negative indices count from the end
+         std::vector<int> poly;
+         std::string token;
+         while (ss >> token)
+         {
+            int idx = atoi(token.c_str());
+            idx = idx < 0 ? (int)verts.size() + idx : idx - 1;
+            if (idx < 0 || idx >= (int)verts.size())
+               return false;
+            poly.push_back(idx);
+         }
+
+         for (size_t i = 2; i < poly.size(); ++i)
+            faces.push_back(cg::point_3i(poly[0], poly[i - 1], poly[i]));
+      }
+   }
+
+   return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include "object.h"
+#include "scene.h"
+#include "bvh.h"
+
+// Indexed triangle mesh as a single scene object.
+// The faces get their own bvh, so a ray costs O(log faces) and the scene bvh sees
+// the whole mesh as one box. Hit normals are interpolated from area-weighted vertex normals.
+struct mesh_obj
+   : object
+   , boost::noncopyable
+{
+   mesh_obj(std::vector<point_3> const & verts, std::vector<cg::point_3i> const & faces);
+
+   virtual bool intersect_ray(line_3 const & l, intersect_detail * detail);
+   virtual bool intersect_seg(segment_3 const & s, intersect_detail * detail);
+   // geometric normal of a face through p, linear in faces count, the tracer takes normals from the hit
+   virtual point_3 normal(point_3 const & p);
+   virtual optional<rectangle_3> bounds();
+
+   size_t faces_count() const { return faces_.size(); }
+
+private:
+   // turns the flat normal of a hit into the interpolated one
+   void smooth(int face, point_3 const & view, intersect_detail & detail) const;
+
+private:
+   std::vector<point_3>      verts_;
+   std::vector<point_3>      normals_;
+   std::vector<cg::point_3i> faces_;
+
+   scene       tris_; // triangle i is face i
+   scene_bvh   bvh_;
+   rectangle_3 bound_;
+};
+
+// reads "v" and "f" records of a wavefront obj file, polygons are split into fans
+bool load_obj(std::string const & path, std::vector<point_3> & verts, std::vector<cg::point_3i> & faces);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "primitives.h"
+
 struct intersect_detail
 {
    point_3 pos;
@@ -26,6 +28,8 @@ struct object
    virtual bool intersect_ray(line_3 const & l, intersect_detail * detail) = 0;
    virtual bool intersect_seg(segment_3 const & l, intersect_detail * detail) = 0;
    virtual point_3 normal(point_3 const & p) = 0;
+   // none for objects without finite extent, e.g. planes
+   virtual optional<rectangle_3> bounds() = 0;
 
    material& mat();
    virtual ~object();
@@ -41,9 +45,12 @@ struct plane_obj : public object
    virtual bool intersect_ray(line_3 const & l, intersect_detail * detail);
    virtual bool intersect_seg(segment_3 const & l, intersect_detail * detail);
    virtual point_3 normal(point_3 const & p);
+   virtual optional<rectangle_3> bounds();
+
+   plane const & get_plane() const { return prim_.pl; }
 
 private:
-   plane p_;
+   plane_prim prim_;
 };
 
 struct sphere_obj : public object
@@ -53,14 +60,13 @@ struct sphere_obj : public object
    virtual bool intersect_ray(line_3 const & line, intersect_detail * detail);
    virtual bool intersect_seg(segment_3 const & s, intersect_detail * detail);
    virtual point_3 normal(point_3 const & p);
+   virtual optional<rectangle_3> bounds();
 
-private:
-   optional<double> intersect_ray_impl(line_3 const & line);
-
+   point_3 const & center() const { return prim_.center; }
+   double          radius() const { return prim_.radius; }
 
 private:
-   point_3 center_;
-   double radius_;
+   sphere_prim prim_;
 };
 
 typedef boost::shared_ptr<object> object_ptr;
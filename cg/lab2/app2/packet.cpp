@@ -0,0 +1,160 @@
+#include "stdafx.h"
+
+#include "packet.h"
+
+ray_packet::ray_packet( point_3 const & origin, point_3 const * dirs )
+   : ox(_mm_set1_ps((float)origin.x))
+   , oy(_mm_set1_ps((float)origin.y))
+   , oz(_mm_set1_ps((float)origin.z))
+   , dx(_mm_setr_ps((float)dirs[0].x, (float)dirs[1].x, (float)dirs[2].x, (float)dirs[3].x))
+   , dy(_mm_setr_ps((float)dirs[0].y, (float)dirs[1].y, (float)dirs[2].y, (float)dirs[3].y))
+   , dz(_mm_setr_ps((float)dirs[0].z, (float)dirs[1].z, (float)dirs[2].z, (float)dirs[3].z))
+{
+}
+
+ray_packet::ray_packet( point_3 const * origins, point_3 const * dirs )
+   : ox(_mm_setr_ps((float)origins[0].x, (float)origins[1].x, (float)origins[2].x, (float)origins[3].x))
+   , oy(_mm_setr_ps((float)origins[0].y, (float)origins[1].y, (float)origins[2].y, (float)origins[3].y))
+   , oz(_mm_setr_ps((float)origins[0].z, (float)origins[1].z, (float)origins[2].z, (float)origins[3].z))
+   , dx(_mm_setr_ps((float)dirs[0].x, (float)dirs[1].x, (float)dirs[2].x, (float)dirs[3].x))
+   , dy(_mm_setr_ps((float)dirs[0].y, (float)dirs[1].y, (float)dirs[2].y, (float)dirs[3].y))
+   , dz(_mm_setr_ps((float)dirs[0].z, (float)dirs[1].z, (float)dirs[2].z, (float)dirs[3].z))
+{
+}
+
+bool packet_scene::build( scene const & sc )
+{
+   sx_.clear(); sy_.clear(); sz_.clear(); sr2_.clear();
+   nx_.clear(); ny_.clear(); nz_.clear(); nd_.clear();
+
+   if (!sc.triangles().empty() || !sc.customs().empty())
+      return false;
+
+   for (size_t i = 0; i != sc.spheres().size(); ++i)
+   {
+      sphere_prim const & s = sc.spheres()[i];
+      sx_.push_back((float)s.center.x);
+      sy_.push_back((float)s.center.y);
+      sz_.push_back((float)s.center.z);
+      sr2_.push_back((float)(s.radius * s.radius));
+   }
+
+   for (size_t i = 0; i != sc.planes().size(); ++i)
+   {
+      plane_prim const & p = sc.planes()[i];
+      nx_.push_back((float)p.pl.n().x);
+      ny_.push_back((float)p.pl.n().y);
+      nz_.push_back((float)p.pl.n().z);
+      nd_.push_back((float)p.pl.d());
+   }
+
+   return true;
+}
+
+prim_ref packet_scene::ref( int idx ) const
+{
+   int const spheres = (int)sx_.size();
+   return idx < spheres ? prim_ref(prim_ref::sphere, idx) : prim_ref(prim_ref::plane, idx - spheres);
+}
+
+namespace
+{
+   inline __m128 dot(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+   {
+      return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+   }
+
+   inline __m128 select(__m128 mask, __m128 a, __m128 b)
+   {
+      return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+   }
+
+   inline __m128 abs_ps(__m128 a)
+   {
+      return _mm_andnot_ps(_mm_set1_ps(-0.f), a);
+   }
+
+   // |a - b| <= err
+   inline __m128 within(__m128 a, __m128 b, __m128 err)
+   {
+      return _mm_cmple_ps(abs_ps(_mm_sub_ps(a, b)), err);
+   }
+}
+
+void packet_scene::intersect( ray_packet const & rays, packet_hit & hit ) const
+{
+   // same thresholds as the scalar sphere_obj and plane_obj tests
+   __m128 const sphere_eps = _mm_set1_ps(1e-6f);
+   __m128 const plane_eps  = _mm_set1_ps(0.001f);
+   __m128 const zero       = _mm_setzero_ps();
+   // relative error of the float tests, with a margin for rounding the double input
+   __m128 const rel_err    = _mm_set1_ps(1e-5f);
+
+   __m128 best = _mm_set1_ps(FLT_MAX);
+   __m128 idx  = _mm_castsi128_ps(_mm_set1_epi32(-1));
+   __m128 uncertain = zero;
+
+   int const spheres = (int)sx_.size();
+   for (int i = 0; i != spheres; ++i)
+   {
+      __m128 const lx = _mm_sub_ps(_mm_set1_ps(sx_[i]), rays.ox);
+      __m128 const ly = _mm_sub_ps(_mm_set1_ps(sy_[i]), rays.oy);
+      __m128 const lz = _mm_sub_ps(_mm_set1_ps(sz_[i]), rays.oz);
+
+      __m128 const l2oc = dot(lx, ly, lz, lx, ly, lz);
+      __m128 const tca  = dot(lx, ly, lz, rays.dx, rays.dy, rays.dz);
+      __m128 const t2hc = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(sr2_[i]), l2oc), _mm_mul_ps(tca, tca));
+
+      __m128 const has_root = _mm_cmpgt_ps(t2hc, zero);
+      __m128 const thc  = _mm_sqrt_ps(_mm_max_ps(t2hc, zero));
+
+      // near root unless the origin is inside the sphere
+      __m128 const tnear = _mm_sub_ps(tca, thc);
+      __m128 const tfar  = _mm_add_ps(tca, thc);
+      __m128 const t     = select(_mm_cmpgt_ps(tnear, sphere_eps), tnear, tfar);
+
+      __m128 const valid  = _mm_and_ps(has_root, _mm_cmpgt_ps(t, sphere_eps));
+      __m128 const closer = _mm_and_ps(valid, _mm_cmplt_ps(t, best));
+
+      // t2hc is a sum of terms up to l2oc + r^2 + tca^2; the square root turns its error into
+      // t2hc_err / (2 thc) in thc, unbounded at a graze (thc = 0 gives inf, also uncertain)
+      __m128 const t2hc_err = _mm_mul_ps(rel_err, _mm_add_ps(_mm_add_ps(l2oc, _mm_set1_ps(sr2_[i])), _mm_mul_ps(tca, tca)));
+      __m128 const t_err    = _mm_add_ps(_mm_mul_ps(rel_err, _mm_add_ps(abs_ps(tca), thc)), _mm_div_ps(t2hc_err, thc));
+      uncertain = _mm_or_ps(uncertain, within(t2hc, zero, t2hc_err));
+      uncertain = _mm_or_ps(uncertain, _mm_and_ps(has_root, within(t, sphere_eps, t_err)));
+      uncertain = _mm_or_ps(uncertain, _mm_and_ps(valid, within(t, best, t_err)));
+
+      best = select(closer, t, best);
+      idx  = select(closer, _mm_castsi128_ps(_mm_set1_epi32(i)), idx);
+   }
+
+   int const planes = (int)nx_.size();
+   for (int i = 0; i != planes; ++i)
+   {
+      __m128 const nx = _mm_set1_ps(nx_[i]);
+      __m128 const ny = _mm_set1_ps(ny_[i]);
+      __m128 const nz = _mm_set1_ps(nz_[i]);
+
+      __m128 const den = dot(nx, ny, nz, rays.dx, rays.dy, rays.dz);
+      __m128 const num = _mm_add_ps(dot(nx, ny, nz, rays.ox, rays.oy, rays.oz), _mm_set1_ps(nd_[i]));
+
+      // division by a zero den gives inf or NaN, both fail the comparisons below
+      __m128 const t = _mm_div_ps(_mm_sub_ps(zero, num), den);
+
+      __m128 const valid  = _mm_cmpgt_ps(t, plane_eps);
+      __m128 const closer = _mm_and_ps(valid, _mm_cmplt_ps(t, best));
+
+      // the error of num over |den|, inf and NaN make no lane uncertain
+      __m128 const t_err = _mm_div_ps(_mm_mul_ps(rel_err, _mm_add_ps(abs_ps(num), abs_ps(_mm_set1_ps(nd_[i])))), abs_ps(den));
+      uncertain = _mm_or_ps(uncertain, within(t, plane_eps, t_err));
+      uncertain = _mm_or_ps(uncertain, _mm_and_ps(valid, within(t, best, t_err)));
+
+      best = select(closer, t, best);
+      idx  = select(closer, _mm_castsi128_ps(_mm_set1_epi32(spheres + i)), idx);
+   }
+
+   hit.t = best;
+   _mm_storeu_si128((__m128i *)hit.idx, _mm_castps_si128(idx));
+   hit.mask = _mm_movemask_ps(_mm_cmplt_ps(best, _mm_set1_ps(FLT_MAX)));
+   hit.uncertain = _mm_movemask_ps(uncertain);
+}
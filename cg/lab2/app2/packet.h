@@ -0,0 +1,50 @@
+#pragma once
+
+#include <emmintrin.h>
+
+#include "scene.h"
+
+// four rays, one per SSE lane
+struct ray_packet
+{
+   enum { size = 4 };
+
+   ray_packet(point_3 const & origin, point_3 const * dirs);
+   ray_packet(point_3 const * origins, point_3 const * dirs);
+
+   __m128 ox, oy, oz;
+   __m128 dx, dy, dz; // unit directions
+};
+
+struct packet_hit
+{
+   __m128 t;                     // distance along the ray, FLT_MAX in lanes without a hit
+   int    idx[ray_packet::size]; // index in packet_scene, -1 in lanes without a hit
+   int    mask;                  // bit i is set if lane i hit something
+   int    uncertain;             // bit i is set if float rounding may have decided lane i: a grazing
+                                 // hit or miss, a near tie of two primitives, a hit next to the origin
+};
+
+// Spheres and planes of the scene laid out as SoA float arrays,
+// so a whole packet is tested against one primitive per iteration.
+// Single precision is enough to find the closest primitive,
+// the exact hit is then recomputed by the scene.
+// Lanes in packet_hit::uncertain have to be retraced by the scalar path.
+struct packet_scene
+{
+   // false if sc has anything but spheres and planes,
+   // such a scene has to be traced by the scalar path
+   bool build(scene const & sc);
+
+   void intersect(ray_packet const & rays, packet_hit & hit) const;
+
+   // spheres go first, then planes
+   prim_ref ref(int idx) const;
+   size_t size() const { return sx_.size() + nx_.size(); }
+
+private:
+   // sphere centers and squared radii
+   std::vector<float> sx_, sy_, sz_, sr2_;
+   // plane normals and offsets
+   std::vector<float> nx_, ny_, nz_, nd_;
+};
@@ -0,0 +1,206 @@
+#include "stdafx.h"
+
+#include "primitives.h"
+#include "object.h"
+
+namespace
+{
+   void fill_detail( point_3 const & view, point_3 const & pos, point_3 const & n, double t, intersect_detail * detail )
+   {
+      detail->pos = pos;
+      detail->n = n;
+      detail->t = t;
+      double cs = view * n;
+      point_3 refl = view - n * (2 * cs);
+      detail->reflect = refl;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+sphere_prim::sphere_prim( point_3 const & c, double r )
+   : center(c)
+   , radius(r)
+{
+}
+
+bool sphere_prim::intersect_ray( line_3 const & line, intersect_detail * detail ) const
+{
+   optional<double> t = intersect_ray_impl(line);
+   if (!t)
+      return false;
+
+   if (detail)
+   {
+      point_3 pos = line(*t);
+      fill_detail(line.r(), pos, normal(pos), *t, detail);
+   }
+   return true;
+}
+
+bool sphere_prim::intersect_seg( segment_3 const & s, intersect_detail * detail ) const
+{
+   line_3 l(s.P0(), s.P1(), cg::line::by_points);
+
+   optional<double> t = intersect_ray_impl(l);
+   if (!t || !cg::le(*t, cg::length(s)))
+      return false;
+
+   if (detail)
+   {
+      point_3 pos = s(*t);
+      fill_detail(direction(s), pos, normal(pos), *t, detail);
+   }
+   return true;
+}
+
+point_3 sphere_prim::normal( point_3 const & p ) const
+{
+   return cg::normalized_safe(p - center);
+}
+
+rectangle_3 sphere_prim::bounds() const
+{
+   return cg::rectangle_by_sphere(center, radius);
+}
+
+optional<double> sphere_prim::intersect_ray_impl( line_3 const & line ) const
+{
+   point_3 const l = center - line.p(); // direction vector
+   double const L2OC = l * l; // squared distance
+   double const tca = l * line.r(); // closest dist to center
+   double t2hc = radius * radius - L2OC + tca * tca;
+   double t2;
+
+   if (t2hc <= 0.0)
+      return boost::none;
+
+   t2hc = sqrt(t2hc);
+
+   double t;
+   if (tca < t2hc)
+   {
+      t = tca + t2hc;
+      t2 = tca - t2hc;
+   }
+   else
+   {
+      t = tca - t2hc;
+      t2 = tca + t2hc;
+   }
+
+   if (fabs(t) < 1e-6)
+      t = t2;
+
+   if (t > 1e-6)
+      return t;
+   else
+      return boost::none;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+plane_prim::plane_prim( point_3 const & n, point_3 const & p )
+   : pl(n, p)
+{
+}
+
+plane_prim::plane_prim( plane const & pl )
+   : pl(pl)
+{
+}
+
+bool plane_prim::intersect_ray( line_3 const & l, intersect_detail * detail ) const
+{
+   double t;
+   if (!cg::has_intersection(pl, l, &t) || !cg::gt(t, 0, 0.001))
+      return false;
+
+   if (detail)
+      fill_detail(l.r(), l(t), pl.n(), t, detail);
+   return true;
+}
+
+bool plane_prim::intersect_seg( segment_3 const & s, intersect_detail * detail ) const
+{
+   double t;
+   if (!cg::has_intersection(s, pl, &t) || !cg::gt(t, 0, 0.001))
+      return false;
+
+   if (detail)
+      fill_detail(direction(s), s(t), pl.n(), t, detail);
+   return true;
+}
+
+point_3 plane_prim::normal( point_3 const & p ) const
+{
+   return pl.n();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+triangle_prim::triangle_prim( point_3 const & a, point_3 const & b, point_3 const & c )
+   : a(a)
+   , e1(b - a)
+   , e2(c - a)
+   , n(cg::normalized_safe((b - a) ^ (c - a)))
+{
+}
+
+bool triangle_prim::intersect_ray( line_3 const & l, intersect_detail * detail ) const
+{
+   double t, u, v;
+   if (!intersect_impl(l.p(), l.r(), t, u, v) || t <= 1e-6)
+      return false;
+
+   if (detail)
+      fill_detail(l.r(), l(t), n * l.r() > 0 ? -n : n, t, detail);
+   return true;
+}
+
+bool triangle_prim::intersect_seg( segment_3 const & s, intersect_detail * detail ) const
+{
+   point_3 const d = s.P1() - s.P0();
+
+   double t, u, v;
+   if (!intersect_impl(s.P0(), d, t, u, v) || t <= 1e-6 || t > 1)
+      return false;
+
+   if (detail)
+   {
+      point_3 const view = direction(s);
+      fill_detail(view, s.P0() + d * t, n * view > 0 ? -n : n, t * cg::norm(d), detail);
+   }
+   return true;
+}
+
+rectangle_3 triangle_prim::bounds() const
+{
+   rectangle_3 res;
+   res |= a;
+   res |= a + e1;
+   res |= a + e2;
+   return res;
+}
+
+bool triangle_prim::intersect_impl( point_3 const & org, point_3 const & dir, double & t, double & u, double & v ) const
+{
+   point_3 const p = dir ^ e2;
+   double const det = e1 * p;
+   if (cg::eq_zero(det, 1e-12))
+      return false;
+
+   double const inv_det = 1. / det;
+   point_3 const s = org - a;
+   u = (s * p) * inv_det;
+   if (u < 0 || u > 1)
+      return false;
+
+   point_3 const q = s ^ e1;
+   v = (dir * q) * inv_det;
+   if (v < 0 || u + v > 1)
+      return false;
+
+   t = (e2 * q) * inv_det;
+   return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+struct intersect_detail;
+
+// Geometric primitives stored by value in the scene arrays (see scene.h).
+// Intersections are plain member calls, sphere_obj and plane_obj wrap these for the object interface.
+
+struct sphere_prim
+{
+   sphere_prim(point_3 const & c, double r);
+
+   bool intersect_ray(line_3 const & l, intersect_detail * detail) const;
+   bool intersect_seg(segment_3 const & s, intersect_detail * detail) const;
+   point_3 normal(point_3 const & p) const;
+   rectangle_3 bounds() const;
+
+   point_3 center;
+   double  radius;
+
+private:
+   optional<double> intersect_ray_impl(line_3 const & l) const;
+};
+
+struct plane_prim
+{
+   plane_prim(point_3 const & n, point_3 const & p);
+   explicit plane_prim(plane const & pl);
+
+   bool intersect_ray(line_3 const & l, intersect_detail * detail) const;
+   bool intersect_seg(segment_3 const & s, intersect_detail * detail) const;
+   point_3 normal(point_3 const & p) const;
+
+   plane pl;
+};
+
+// one-sided geometry, two-sided shading: the hit normal is turned towards the ray
+struct triangle_prim
+{
+   triangle_prim(point_3 const & a, point_3 const & b, point_3 const & c);
+
+   bool intersect_ray(line_3 const & l, intersect_detail * detail) const;
+   bool intersect_seg(segment_3 const & s, intersect_detail * detail) const;
+   rectangle_3 bounds() const;
+
+   // moller-trumbore wants a vertex and two edges
+   point_3 a;
+   point_3 e1;
+   point_3 e2;
+   point_3 n;  // unit geometric normal
+
+private:
+   // t in units of dir, u and v are barycentrics of the second and third vertex
+   bool intersect_impl(point_3 const & org, point_3 const & dir, double & t, double & u, double & v) const;
+};
@@ -0,0 +1,209 @@
+#include "stdafx.h"
+
+#include "progressive.h"
+#include "tracer.h"
+
+namespace
+{
+   // halton sequence, radical inverse of i in base b
+   double radical_inverse( int i, int b )
+   {
+      double res = 0;
+      for (double f = 1. / b; i; i /= b, f /= b)
+         res += f * (i % b);
+      return res;
+   }
+
+   // the image can be reprojected only while the eye stays in place
+   bool same_view( screen_camera const & a, screen_camera const & b )
+   {
+      return a.width() == b.width() && a.height() == b.height() && a.origin() == b.origin()
+         && a.ray_dir(0, 0) == b.ray_dir(0, 0) && a.ray_dir(a.width(), a.height()) == b.ray_dir(b.width(), b.height());
+   }
+}
+
+progressive::progressive( int max_samples, int threads )
+   : max_samples_(cg::max(max_samples, 1))
+   , threads_(threads > 0 ? threads : omp::get_max_threads())
+   , rounds_(0)
+{
+}
+
+void progressive::reset()
+{
+   cam_.reset();
+   sum_.clear();
+   count_.clear();
+   rounds_ = 0;
+}
+
+bool progressive::render( tracer const & tr, screen_camera const & cam, framebuffer & fb, bool const * alive )
+{
+   Assert(fb.width() == cam.width() && fb.height() == cam.height());
+
+   // a minimized window, keep the history for when it comes back
+   if (cam.width() == 0 || cam.height() == 0)
+      return true;
+
+   if (cam_ && !same_view(*cam_, cam))
+   {
+      if (cam_->origin() == cam.origin())
+      {
+         resample(cam);
+         show(fb, 8);
+      }
+      else
+         reset();
+   }
+
+   int const w = cam.width();
+   int const h = cam.height();
+
+   if (!cam_)
+   {
+      sum_.assign(w * h, cg::color_black());
+      count_.assign(w * h, 0.f);
+   }
+   cam_ = cam;
+
+   // coarse passes trace the pixels no earlier pass has touched
+   int const steps[] = { 8, 4, 2, 1 };
+   std::vector<int> pixels;
+   for (size_t s = 0; s != sizeof(steps) / sizeof(steps[0]); ++s)
+   {
+      int const step = steps[s];
+
+      pixels.clear();
+      for (int y = 0; y < h; y += step)
+         for (int x = 0; x < w; x += step)
+            if (count_[y * w + x] == 0)
+               pixels.push_back(y * w + x);
+
+      if (pixels.empty())
+         continue;
+
+      bool const done = trace(tr, cam, pixels, 0, 0, alive);
+      show(fb, step);
+      if (!done)
+         return false;
+   }
+
+   // refinement, every round samples each pixel at the next point of the jitter sequence
+   for (;;)
+   {
+      pixels.clear();
+      for (int i = 0; i != w * h; ++i)
+         if (count_[i] < max_samples_)
+            pixels.push_back(i);
+
+      if (pixels.empty())
+         return true;
+
+      ++rounds_;
+      bool const done = trace(tr, cam, pixels, radical_inverse(rounds_, 2), radical_inverse(rounds_, 3), alive);
+      show(fb, 1);
+      if (!done)
+         return false;
+   }
+}
+
+void progressive::resample( screen_camera const & cam )
+{
+   screen_camera const & old = *cam_;
+   int const ow = old.width();
+   int const oh = old.height();
+   int const w = cam.width();
+   int const h = cam.height();
+
+   std::vector<colorf> sum(w * h, cg::color_black());
+   std::vector<float>  count(w * h, 0.f);
+
+   // every new pixel takes the old pixel its center falls into, with a small weight,
+   // so the stale estimate fades away as fresh samples arrive
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads_)
+#endif
+   for (int y = 0; y < h; ++y)
+      for (int x = 0; x < w; ++x)
+      {
+         double ox, oy;
+         if (!old.project(cam.ray_dir(x + .5, y + .5), ox, oy))
+            continue;
+
+         int const ix = (int)floor(ox);
+         int const iy = (int)floor(oy);
+         if (ix < 0 || iy < 0 || ix >= ow || iy >= oh)
+            continue;
+
+         float const c = count_[iy * ow + ix];
+         if (c == 0)
+            continue;
+
+         float const weight = cg::min(c, (float)resample_weight);
+         sum  [y * w + x] = sum_[iy * ow + ix] * (weight / c);
+         count[y * w + x] = weight;
+      }
+
+   sum_.swap(sum);
+   count_.swap(count);
+   cam_ = cam;
+}
+
+bool progressive::trace( tracer const & tr, screen_camera const & cam, std::vector<int> const & pixels, double dx, double dy, bool const * alive )
+{
+   int const w = cam.width();
+   int const n = (int)pixels.size();
+   int const groups = (n + ray_packet::size - 1) / ray_packet::size;
+
+   // each pixel occurs once per call, so the accumulators are written without locks
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16) num_threads(threads_)
+#endif
+   for (int g = 0; g < groups; ++g)
+   {
+      if (!*alive)
+         continue;
+
+      // the tail packet repeats the last pixel
+      int     idx[ray_packet::size];
+      point_3 dirs[ray_packet::size];
+      colorf  colors[ray_packet::size];
+      for (int k = 0; k != ray_packet::size; ++k)
+      {
+         idx[k] = pixels[cg::min(g * ray_packet::size + k, n - 1)];
+         dirs[k] = cam.ray_dir(idx[k] % w + dx, idx[k] / w + dy);
+      }
+
+      // keyed by the round and the first pixel of the packet
+      rand_stream rng(tr.seed(), rounds_, idx[0]);
+      tr.trace(cam.origin(), dirs, colors, rng);
+
+      for (int k = 0; k != cg::min((int)ray_packet::size, n - g * ray_packet::size); ++k)
+      {
+         sum_[idx[k]] += colors[k];
+         count_[idx[k]] += 1;
+      }
+   }
+
+   return *alive;
+}
+
+void progressive::show( framebuffer & fb, int step ) const
+{
+   int const w = fb.width();
+   int const h = fb.height();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads_)
+#endif
+   for (int y = 0; y < h; ++y)
+      for (int x = 0; x < w; ++x)
+      {
+         int i = y * w + x;
+         if (count_[i] == 0)
+            i = (y - y % step) * w + (x - x % step);
+
+         if (count_[i] > 0)
+            fb(x, y) = sum_[i] * (1.f / count_[i]);
+      }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "framebuffer.h"
+#include "screen_camera.h"
+
+struct tracer;
+
+// Progressive renderer that keeps its work between calls.
+// The first image comes from coarse passes at 1/8, 1/4 and 1/2 resolution, each tracing
+// only the pixels the previous ones skipped, then the full one. After that every round adds
+// one jittered sample per pixel and the picture converges.
+// When the camera changes (e.g. the window is resized) the accumulated image is reprojected
+// into the new one, so the refinement goes on from there instead of from scratch.
+struct progressive
+{
+   // threads == 0 means one thread per core
+   explicit progressive(int max_samples = 256, int threads = 0);
+
+   // forgets everything traced so far
+   void reset();
+
+   // returns true when every pixel has max_samples, false if stopped through alive
+   // fb is resized to the camera and updated after every pass, alive is polled per ray packet
+   bool render(tracer const & tr, screen_camera const & cam, framebuffer & fb, bool const * alive);
+
+   // reprojected pixels weigh as much as this many fresh samples
+   static const int resample_weight = 2;
+
+private:
+   void resample(screen_camera const & cam);
+   // traces pixels[i] at (x + dx, y + dy), false if stopped through alive
+   bool trace(tracer const & tr, screen_camera const & cam, std::vector<int> const & pixels, double dx, double dy, bool const * alive);
+   // pixels with no samples yet show the sample step pixels up and to the left
+   void show(framebuffer & fb, int step) const;
+
+private:
+   int max_samples_;
+   int threads_;
+
+   optional<screen_camera> cam_;
+   std::vector<colorf>     sum_;
+   std::vector<float>      count_;
+   int                     rounds_; // refinement rounds done, indexes the jitter sequence
+};
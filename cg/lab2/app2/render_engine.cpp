@@ -0,0 +1,62 @@
+#include "stdafx.h"
+
+#include "render_engine.h"
+#include "tracer.h"
+
+render_engine::render_engine( int tile_size, int threads )
+   : tile_size_(cg::max(tile_size, 1))
+   , threads_(threads > 0 ? threads : omp::get_max_threads())
+{
+}
+
+bool render_engine::render( tracer const & tr, screen_camera const & cam, framebuffer & fb, bool const * alive ) const
+{
+   Assert(fb.width() == cam.width() && fb.height() == cam.height());
+
+   int const tiles_x = (fb.width()  + tile_size_ - 1) / tile_size_;
+   int const tiles_y = (fb.height() + tile_size_ - 1) / tile_size_;
+   int const tiles = tiles_x * tiles_y;
+
+   // omp for can't be left early, so after cancellation the rest of the tiles are just skipped
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads_)
+#endif
+   for (int tile = 0; tile < tiles; ++tile)
+   {
+      if (!*alive)
+         continue;
+
+      render_tile(tr, cam, fb, (tile % tiles_x) * tile_size_, (tile / tiles_x) * tile_size_);
+   }
+
+   return *alive;
+}
+
+void render_engine::render_tile( tracer const & tr, screen_camera const & cam, framebuffer & fb, int x0, int y0 ) const
+{
+   int const x1 = cg::min(x0 + tile_size_, fb.width());
+   int const y1 = cg::min(y0 + tile_size_, fb.height());
+
+   // 2x2 pixel quads are the most coherent packets, lanes past the tile edge repeat the last pixel
+   for (int y = y0; y < y1; y += 2)
+      for (int x = x0; x < x1; x += 2)
+      {
+         int     px[ray_packet::size], py[ray_packet::size];
+         point_3 dirs[ray_packet::size];
+         colorf  colors[ray_packet::size];
+
+         for (int i = 0; i != ray_packet::size; ++i)
+         {
+            px[i] = cg::min(x + (i & 1), x1 - 1);
+            py[i] = cg::min(y + (i >> 1), y1 - 1);
+            dirs[i] = cam.ray_dir(px[i], py[i]);
+         }
+
+         // keyed by the quad, so the noise doesn't depend on which thread got the tile
+         rand_stream rng(tr.seed(), y * fb.width() + x);
+         tr.trace(cam.origin(), dirs, colors, rng);
+
+         for (int i = 0; i != ray_packet::size; ++i)
+            fb(px[i], py[i]) = colors[i];
+      }
+}
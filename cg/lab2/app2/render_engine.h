@@ -0,0 +1,30 @@
+#pragma once
+
+#include "framebuffer.h"
+#include "screen_camera.h"
+
+struct tracer;
+
+// Splits the frame into square tiles and traces them on a pool of threads.
+// Tiles are handed out dynamically, so a thread that is done with a cheap
+// tile immediately grabs the next one instead of idling.
+// Nothing here touches GDI: pixels go straight into the framebuffer.
+struct render_engine
+{
+   // threads == 0 means one thread per core
+   explicit render_engine(int tile_size = 32, int threads = 0);
+
+   // traces the whole frame into fb, returns false if *alive was dropped
+   // alive is polled once per tile
+   bool render(tracer const & tr, screen_camera const & cam, framebuffer & fb, bool const * alive) const;
+
+   int tile_size() const { return tile_size_; }
+   int threads  () const { return threads_;   }
+
+private:
+   void render_tile(tracer const & tr, screen_camera const & cam, framebuffer & fb, int x0, int y0) const;
+
+private:
+   int tile_size_;
+   int threads_;
+};
@@ -0,0 +1,117 @@
+#include "stdafx.h"
+
+#include "sampling.h"
+
+void make_basis( point_3 const & w, point_3 & u, point_3 & v )
+{
+   // any axis not parallel to w completes the basis
+   point_3 a = cg::abs(w.x) < 0.6 ? point_3(1, 0, 0) : point_3(0, 1, 0);
+   u = cg::normalized(a ^ w);
+   v = w ^ u;
+}
+
+point_3 uniform_sphere( double u1, double u2 )
+{
+   double const z = 1 - 2 * u1;
+   double const r = sqrt(cg::max(0., 1 - z * z));
+   double const phi = 2 * cg::pi * u2;
+   return point_3(r * cos(phi), r * sin(phi), z);
+}
+
+point_3 uniform_hemisphere( point_3 const & n, double u1, double u2 )
+{
+   point_3 u, v;
+   make_basis(n, u, v);
+
+   double const z = u1;
+   double const r = sqrt(cg::max(0., 1 - z * z));
+   double const phi = 2 * cg::pi * u2;
+   return (r * cos(phi)) * u + (r * sin(phi)) * v + z * n;
+}
+
+point_3 cosine_hemisphere( point_3 const & n, double u1, double u2 )
+{
+   point_3 u, v;
+   make_basis(n, u, v);
+
+   // malley: uniform point on the disk lifted to the hemisphere
+   double const r = sqrt(u1);
+   double const phi = 2 * cg::pi * u2;
+   return (r * cos(phi)) * u + (r * sin(phi)) * v + sqrt(cg::max(0., 1 - u1)) * n;
+}
+
+namespace
+{
+   // heights and radii for a batch, the part of the three samplers that vectorizes;
+   // sines and cosines are left to the scalar loops, SSE2 has no trigonometry
+   enum dist_kind { sphere_dist, hemisphere_dist, cosine_dist };
+
+   void radial( rand_stream & rng, dist_kind kind, float * z, float * r, float * phi, size_t count )
+   {
+      __m128 const one = _mm_set1_ps(1.f);
+      __m128 const two = _mm_set1_ps(2.f);
+      __m128 const two_pi = _mm_set1_ps((float)(2 * cg::pi));
+
+      for (size_t i = 0; i < count; i += 4)
+      {
+         __m128 const u1 = rng.uniform4();
+         __m128 const u2 = rng.uniform4();
+
+         __m128 vz, vr;
+         if (kind == sphere_dist)
+         {
+            vz = _mm_sub_ps(one, _mm_mul_ps(two, u1));
+            vr = _mm_sqrt_ps(_mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(one, _mm_mul_ps(vz, vz))));
+         }
+         else if (kind == hemisphere_dist)
+         {
+            vz = u1;
+            vr = _mm_sqrt_ps(_mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(one, _mm_mul_ps(vz, vz))));
+         }
+         else
+         {
+            vz = _mm_sqrt_ps(_mm_sub_ps(one, u1));
+            vr = _mm_sqrt_ps(u1);
+         }
+
+         _mm_storeu_ps(z + i, vz);
+         _mm_storeu_ps(r + i, vr);
+         _mm_storeu_ps(phi + i, _mm_mul_ps(two_pi, u2));
+      }
+   }
+
+   void directions( rand_stream & rng, dist_kind kind, point_3 const & u, point_3 const & v, point_3 const & w, point_3 * dst, size_t count )
+   {
+      // batches keep the scratch on the stack
+      size_t const batch = 64;
+      float z[batch], r[batch], phi[batch];
+
+      for (size_t first = 0; first < count; first += batch)
+      {
+         size_t const n = cg::min(batch, count - first);
+         radial(rng, kind, z, r, phi, n);
+
+         for (size_t i = 0; i != n; ++i)
+            dst[first + i] = (r[i] * cos(phi[i])) * u + (r[i] * sin(phi[i])) * v + (double)z[i] * w;
+      }
+   }
+}
+
+void uniform_sphere( rand_stream & rng, point_3 * dst, size_t count )
+{
+   directions(rng, sphere_dist, point_3(1, 0, 0), point_3(0, 1, 0), point_3(0, 0, 1), dst, count);
+}
+
+void uniform_hemisphere( rand_stream & rng, point_3 const & n, point_3 * dst, size_t count )
+{
+   point_3 u, v;
+   make_basis(n, u, v);
+   directions(rng, hemisphere_dist, u, v, n, dst, count);
+}
+
+void cosine_hemisphere( rand_stream & rng, point_3 const & n, point_3 * dst, size_t count )
+{
+   point_3 u, v;
+   make_basis(n, u, v);
+   directions(rng, cosine_dist, u, v, n, dst, count);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "common/rand_stream.h"
+
+// Direction sampling from uniform numbers in [0, 1).
+// The bulk versions draw their numbers from a rand_stream in SSE batches.
+
+// uniform over the unit sphere
+point_3 uniform_sphere(double u1, double u2);
+// uniform over the hemisphere around the unit vector n
+point_3 uniform_hemisphere(point_3 const & n, double u1, double u2);
+// density proportional to the cosine with the unit vector n
+point_3 cosine_hemisphere(point_3 const & n, double u1, double u2);
+
+void uniform_sphere    (rand_stream & rng, point_3 * dst, size_t count);
+void uniform_hemisphere(rand_stream & rng, point_3 const & n, point_3 * dst, size_t count);
+void cosine_hemisphere (rand_stream & rng, point_3 const & n, point_3 * dst, size_t count);
+
+// orthonormal u, v completing the unit vector w
+void make_basis(point_3 const & w, point_3 & u, point_3 & v);
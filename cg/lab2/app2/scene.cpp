@@ -0,0 +1,111 @@
+#include "stdafx.h"
+
+#include "scene.h"
+
+prim_ref scene::add( object_ptr const & obj )
+{
+   if (sphere_obj const * s = dynamic_cast<sphere_obj const *>(obj.get()))
+      return add_sphere(s->center(), s->radius(), obj->mat());
+
+   if (plane_obj const * p = dynamic_cast<plane_obj const *>(obj.get()))
+   {
+      planes_.push_back(plane_prim(p->get_plane()));
+      plane_mats_.push_back(obj->mat());
+      return prim_ref(prim_ref::plane, (int)planes_.size() - 1);
+   }
+
+   customs_.push_back(obj);
+   return prim_ref(prim_ref::custom, (int)customs_.size() - 1);
+}
+
+prim_ref scene::add_sphere( point_3 const & c, double r, material const & m )
+{
+   spheres_.push_back(sphere_prim(c, r));
+   sphere_mats_.push_back(m);
+   return prim_ref(prim_ref::sphere, (int)spheres_.size() - 1);
+}
+
+prim_ref scene::add_plane( point_3 const & n, point_3 const & p, material const & m )
+{
+   planes_.push_back(plane_prim(n, p));
+   plane_mats_.push_back(m);
+   return prim_ref(prim_ref::plane, (int)planes_.size() - 1);
+}
+
+prim_ref scene::add_triangle( point_3 const & a, point_3 const & b, point_3 const & c, material const & m )
+{
+   triangles_.push_back(triangle_prim(a, b, c));
+   triangle_mats_.push_back(m);
+   return prim_ref(prim_ref::triangle, (int)triangles_.size() - 1);
+}
+
+size_t scene::size() const
+{
+   return spheres_.size() + planes_.size() + triangles_.size() + customs_.size();
+}
+
+void scene::refs( std::vector<prim_ref> & res ) const
+{
+   res.clear();
+   res.reserve(size());
+   for (size_t i = 0; i != spheres_.size(); ++i)
+      res.push_back(prim_ref(prim_ref::sphere, (int)i));
+   for (size_t i = 0; i != planes_.size(); ++i)
+      res.push_back(prim_ref(prim_ref::plane, (int)i));
+   for (size_t i = 0; i != triangles_.size(); ++i)
+      res.push_back(prim_ref(prim_ref::triangle, (int)i));
+   for (size_t i = 0; i != customs_.size(); ++i)
+      res.push_back(prim_ref(prim_ref::custom, (int)i));
+}
+
+material const & scene::mat( prim_ref r ) const
+{
+   switch (r.kind)
+   {
+   case prim_ref::sphere  : return sphere_mats_[r.idx];
+   case prim_ref::plane   : return plane_mats_[r.idx];
+   case prim_ref::triangle: return triangle_mats_[r.idx];
+   }
+
+   Assert(r.kind == prim_ref::custom);
+   return customs_[r.idx]->mat();
+}
+
+optional<rectangle_3> scene::bounds( prim_ref r ) const
+{
+   switch (r.kind)
+   {
+   case prim_ref::sphere  : return spheres_[r.idx].bounds();
+   case prim_ref::plane   : return boost::none;
+   case prim_ref::triangle: return triangles_[r.idx].bounds();
+   }
+
+   Assert(r.kind == prim_ref::custom);
+   return customs_[r.idx]->bounds();
+}
+
+bool scene::intersect_ray( prim_ref r, line_3 const & l, intersect_detail * detail ) const
+{
+   switch (r.kind)
+   {
+   case prim_ref::sphere  : return spheres_[r.idx].intersect_ray(l, detail);
+   case prim_ref::plane   : return planes_[r.idx].intersect_ray(l, detail);
+   case prim_ref::triangle: return triangles_[r.idx].intersect_ray(l, detail);
+   }
+
+   Assert(r.kind == prim_ref::custom);
+   return customs_[r.idx]->intersect_ray(l, detail);
+}
+
+bool scene::intersect_seg( prim_ref r, segment_3 const & s, intersect_detail * detail ) const
+{
+   switch (r.kind)
+   {
+   case prim_ref::sphere  : return spheres_[r.idx].intersect_seg(s, detail);
+   case prim_ref::plane   : return planes_[r.idx].intersect_seg(s, detail);
+   case prim_ref::triangle: return triangles_[r.idx].intersect_seg(s, detail);
+   }
+
+   Assert(r.kind == prim_ref::custom);
+   return customs_[r.idx]->intersect_seg(s, detail);
+}
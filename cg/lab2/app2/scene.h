@@ -0,0 +1,59 @@
+#pragma once
+
+#include "object.h"
+
+// handle of a scene primitive, kind picks the array and idx the element in it
+struct prim_ref
+{
+   enum kind_t { none = -1, sphere, plane, triangle, custom };
+
+   prim_ref() : kind(none), idx(-1) {}
+   prim_ref(int kind, int idx) : kind(kind), idx(idx) {}
+
+   bool valid() const { return kind != none; }
+
+   int kind;
+   int idx;
+};
+
+inline bool operator == (prim_ref const & a, prim_ref const & b) { return a.kind == b.kind && a.idx == b.idx; }
+inline bool operator != (prim_ref const & a, prim_ref const & b) { return !(a == b); }
+
+// Scene storage partitioned by primitive kind.
+// Spheres, planes and triangles live in their own contiguous arrays with materials
+// in parallel arrays, so queries over them are non-virtual and touch little memory.
+// Objects of any other type are kept as is and reached through the object interface.
+struct scene
+{
+   // sphere_obj and plane_obj are unpacked into the arrays, everything else is kept as custom
+   prim_ref add(object_ptr const & obj);
+
+   prim_ref add_sphere  (point_3 const & c, double r, material const & m);
+   prim_ref add_plane   (point_3 const & n, point_3 const & p, material const & m);
+   prim_ref add_triangle(point_3 const & a, point_3 const & b, point_3 const & c, material const & m);
+
+   std::vector<sphere_prim>   const & spheres  () const { return spheres_;   }
+   std::vector<plane_prim>    const & planes   () const { return planes_;    }
+   std::vector<triangle_prim> const & triangles() const { return triangles_; }
+   objects                    const & customs  () const { return customs_;   }
+
+   size_t size() const;
+   // every primitive, kind after kind
+   void refs(std::vector<prim_ref> & res) const;
+
+   material const & mat(prim_ref r) const;
+   // none for primitives without finite extent
+   optional<rectangle_3> bounds(prim_ref r) const;
+
+   bool intersect_ray(prim_ref r, line_3 const & l, intersect_detail * detail) const;
+   bool intersect_seg(prim_ref r, segment_3 const & s, intersect_detail * detail) const;
+
+private:
+   std::vector<sphere_prim>   spheres_;
+   std::vector<material>      sphere_mats_;
+   std::vector<plane_prim>    planes_;
+   std::vector<material>      plane_mats_;
+   std::vector<triangle_prim> triangles_;
+   std::vector<material>      triangle_mats_;
+   objects                    customs_;
+};
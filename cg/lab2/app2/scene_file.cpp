@@ -0,0 +1,212 @@
+#include "stdafx.h"
+
+#include <map>
+
+#include "scene_file.h"
+#include "mesh_obj.h"
+
+scene_desc::scene_desc()
+   : ambient(cg::color_white())
+   , cam_origin(0, -20, 0)
+   , cam_dir(0, 0, 0)
+   , cam_fov(30)
+{
+}
+
+scene_desc default_scene()
+{
+   scene_desc desc;
+
+   //object_ptr plane(new plane_obj(cg::normalized(point_3(0, 0, 1)), point_3(0, 0, -3)));
+   ////plane->mat().kr = 0;
+   ////plane->mat().fuzzy_refl = true;
+   //desc.objs.push_back(plane);
+
+   object_ptr s(new sphere_obj(point_3(0, 5, 1), 2));
+   //s->mat().fuzzy_refl = true;
+   s->mat().color = cg::color_yellow();
+   desc.objs.push_back(s);
+
+
+   object_ptr s2(new sphere_obj(point_3(5, 5, 3), 2));
+   s2->mat().fuzzy_refl = true;
+   s->mat().color = cg::color_darkgray();
+   desc.objs.push_back(s2);
+
+
+   desc.ls.push_back(light(point_3(3, 0, 1), colorf(1, 1, 1), 1));
+
+   desc.ambient = cg::color_white();
+
+   return desc;
+}
+
+namespace
+{
+   typedef std::map<std::string, material> materials;
+
+   std::istream & operator >> ( std::istream & in, point_3 & p )
+   {
+      return in >> p.x >> p.y >> p.z;
+   }
+
+   std::istream & operator >> ( std::istream & in, colorf & c )
+   {
+      return in >> c.r >> c.g >> c.b;
+   }
+
+   bool read_material( std::istringstream & in, material & m )
+   {
+      std::string key;
+      while (in >> key)
+      {
+         bool ok = true;
+         if      (key == "color" ) ok = !!(in >> m.color);
+         else if (key == "ka"    ) ok = !!(in >> m.ka);
+         else if (key == "kd"    ) ok = !!(in >> m.kd);
+         else if (key == "kr"    ) ok = !!(in >> m.kr);
+         else if (key == "ks"    ) ok = !!(in >> m.ks);
+         else if (key == "p"     ) ok = !!(in >> m.p);
+         else if (key == "glossy") ok = !!(in >> m.fuzzy_refl);
+         else
+            return false;
+
+         if (!ok)
+            return false;
+      }
+      return true;
+   }
+
+   // the optional material name ending an object line
+   bool read_object_material( std::istringstream & in, materials const & mats, material & m, std::string & error )
+   {
+      std::string name;
+      if (!(in >> name))
+         return true;
+
+      materials::const_iterator it = mats.find(name);
+      if (it == mats.end())
+      {
+         error = "unknown material '" + name + "'";
+         return false;
+      }
+
+      m = it->second;
+      return true;
+   }
+
+   std::string directory_of( std::string const & path )
+   {
+      size_t const slash = path.find_last_of("/\\");
+      return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+   }
+}
+
+bool load_scene_file( std::string const & path, scene_desc & desc, std::string & error )
+{
+   std::ifstream file(path.c_str());
+   if (!file)
+   {
+      error = path + ": can't open";
+      return false;
+   }
+
+   desc = scene_desc();
+   materials mats;
+
+   std::string line;
+   for (int line_no = 1; std::getline(file, line); ++line_no)
+   {
+      line = line.substr(0, line.find('#'));
+
+      std::istringstream in(line);
+      std::string tag;
+      if (!(in >> tag))
+         continue;
+
+      std::string what;
+      bool ok = true;
+      if (tag == "camera")
+         ok = !!(in >> desc.cam_origin >> desc.cam_dir.course >> desc.cam_dir.pitch >> desc.cam_dir.roll >> desc.cam_fov);
+      else if (tag == "ambient")
+         ok = !!(in >> desc.ambient);
+      else if (tag == "light")
+      {
+         point_3 pos;
+         colorf color;
+         double power;
+         ok = !!(in >> pos >> color >> power);
+         if (ok)
+            desc.ls.push_back(light(pos, color, power));
+      }
+      else if (tag == "material")
+      {
+         std::string name;
+         material m;
+         ok = (in >> name) && read_material(in, m);
+         if (ok)
+            mats[name] = m;
+      }
+      else if (tag == "sphere")
+      {
+         point_3 c;
+         double r;
+         object_ptr obj;
+         if ((ok = !!(in >> c >> r)))
+         {
+            obj.reset(new sphere_obj(c, r));
+            ok = read_object_material(in, mats, obj->mat(), what);
+         }
+         if (ok)
+            desc.objs.push_back(obj);
+      }
+      else if (tag == "plane")
+      {
+         point_3 n, p;
+         object_ptr obj;
+         if ((ok = !!(in >> n >> p)))
+         {
+            obj.reset(new plane_obj(cg::normalized_safe(n), p));
+            ok = read_object_material(in, mats, obj->mat(), what);
+         }
+         if (ok)
+            desc.objs.push_back(obj);
+      }
+      else if (tag == "mesh")
+      {
+         std::string mesh_path;
+         std::vector<point_3> verts;
+         std::vector<cg::point_3i> faces;
+         if ((ok = !!(in >> mesh_path)))
+         {
+            if (!load_obj(directory_of(path) + mesh_path, verts, faces))
+            {
+               what = "can't read mesh '" + mesh_path + "'";
+               ok = false;
+            }
+         }
+         if (ok)
+         {
+            object_ptr obj(new mesh_obj(verts, faces));
+            ok = read_object_material(in, mats, obj->mat(), what);
+            if (ok)
+               desc.objs.push_back(obj);
+         }
+      }
+      else
+      {
+         what = "unknown record '" + tag + "'";
+         ok = false;
+      }
+
+      if (!ok)
+      {
+         std::ostringstream msg;
+         msg << path << ":" << line_no << ": " << (what.empty() ? "malformed '" + tag + "' record" : what);
+         error = msg.str();
+         return false;
+      }
+   }
+
+   return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "object.h"
+#include "light.h"
+
+// everything the tracer and the camera need to show a scene
+struct scene_desc
+{
+   scene_desc();
+
+   objects objs;
+   lights  ls;
+   colorf  ambient;
+
+   point_3 cam_origin;
+   cpr     cam_dir;
+   double  cam_fov;
+};
+
+// the scene app2 shows when nothing else is given: two spheres and a light
+scene_desc default_scene();
+
+// Line based text format, '#' starts a comment:
+//    camera   ox oy oz  course pitch roll  fov
+//    ambient  r g b
+//    light    x y z  r g b  power
+//    material name  [color r g b] [ka v] [kd v] [kr v] [ks v] [p v] [glossy 0|1]
+//    sphere   cx cy cz  radius      [material]
+//    plane    nx ny nz  px py pz    [material]
+//    mesh     file.obj              [material]
+// Materials are defined before use, objects without one get material().
+// Mesh paths are relative to the scene file.
+// On failure returns false and error is "file:line: what is wrong".
+bool load_scene_file(std::string const & path, scene_desc & desc, std::string & error);
@@ -0,0 +1,55 @@
+#include "stdafx.h"
+
+#include "screen_camera.h"
+
+screen_camera::screen_camera( point_3 const & origin, cpr const & dir, double fov, int width, int height )
+   : origin_(origin)
+   , width_(width)
+   , height_(height)
+{
+   double xfov, yfov;
+   double ratio = (double)height / width;
+   if (ratio > 1)
+   {
+      xfov = fov / 2;
+      yfov = xfov * ratio / 2;
+   }
+   else
+   {
+      xfov = fov / ratio / 2;
+      yfov = fov / 2;
+   }
+
+   xy_ = polar_point_3( 1, -xfov + dir.course, yfov + dir.pitch);
+   point_3 xY = polar_point_3( 1, -xfov + dir.course, -yfov + dir.pitch);
+   point_3 Xy = polar_point_3( 1, xfov + dir.course, +yfov + dir.pitch);
+   ext_x_ = Xy - xy_;
+   ext_y_ = xY - xy_;
+}
+
+point_3 screen_camera::ray_dir( double scr_x, double scr_y ) const
+{
+   double x_pos_norm = scr_x / width_;
+   double y_pos_norm = scr_y / height_;
+
+   return cg::normalized(xy_ + x_pos_norm * ext_x_ + y_pos_norm * ext_y_);
+}
+
+bool screen_camera::project( point_3 const & dir, double & scr_x, double & scr_y ) const
+{
+   // dir * s = xy_ + u * ext_x_ + v * ext_y_, solved against the normal of the view plane
+   point_3 const n = ext_x_ ^ ext_y_;
+   double const den = dir * n;
+   if (cg::eq_zero(den))
+      return false;
+
+   double const s = (xy_ * n) / den;
+   if (s <= 0)
+      return false;
+
+   point_3 const p = dir * s - xy_;
+   double const nn = n * n;
+   scr_x = ((p ^ ext_y_) * n) / nn * width_;
+   scr_y = ((ext_x_ ^ p) * n) / nn * height_;
+   return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// pinhole camera, maps window pixels to primary ray directions
+struct screen_camera
+{
+   screen_camera(point_3 const & origin, cpr const & dir, double fov, int width, int height);
+
+   point_3 const & origin() const { return origin_; }
+
+   // scr_x, scr_y in pixels, fractional values address points inside a pixel
+   point_3 ray_dir(double scr_x, double scr_y) const;
+   // inverse of ray_dir, false for directions that miss the view plane
+   bool project(point_3 const & dir, double & scr_x, double & scr_y) const;
+
+   int width () const { return width_;  }
+   int height() const { return height_; }
+
+private:
+   point_3 origin_;
+   point_3 xy_;
+   point_3 ext_x_;
+   point_3 ext_y_;
+   int     width_;
+   int     height_;
+};
@@ -9,12 +9,14 @@
 
 #include "targetver.h"
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 // Windows Header Files:
 #include <windows.h>
 
 // C RunTime Header Files
 #include <tchar.h>
+#endif
 
 #pragma once
 
@@ -23,23 +25,33 @@
 #include <cassert>
 #include <vector>
 #include <cmath>
+#include <cfloat>
 #include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <string>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 #include "Geometry/primitives/point.h"
 #include "Geometry/primitives/line.h"
 #include "Geometry/primitives/color.h"
 #include "Geometry/primitives/plane.h"
 #include "Geometry/primitives/segment.h"
+#include "Geometry/primitives/rectangle.h"
 #include "Geometry/primitives/polar_point.h"
 #include "Geometry/primitives/turn.h"
+#ifdef _WIN32
 #include "common/PerfCounter.h"
 #include "common/util.h"
 #include "common/lock.h"
+#endif
+#include "common/omp_utils.h"
 
+#include "boost/cstdint.hpp"
 #include "boost/optional.hpp"
 #include "boost/shared_ptr.hpp"
 #include "boost/scoped_ptr.hpp"
@@ -51,6 +63,7 @@ using cg::colorb;
 using cg::plane;
 using cg::line_3;
 using cg::segment_3;
+using cg::rectangle_3;
 using cg::polar_point_3;
 using cg::cpr;
 
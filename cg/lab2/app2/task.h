@@ -1,3 +1,34 @@
 #pragma once
 
-void render(int win_width, int win_height, HDC dc, bool * is_alive, lock::critsec * cs);
+#include "framebuffer.h"
+#include "progressive.h"
+#include "scene_file.h"
+
+struct tracer;
+
+enum render_mode
+{
+   render_tiles,      // depth-first per pixel, see render_engine.h
+   render_wavefront,  // breadth-first per bounce, see wavefront.h
+   render_progressive // coarse to fine and converging, see progressive.h
+};
+
+// traces the scene into the whole fb, returns false if cancelled through is_alive
+bool render(framebuffer & fb, bool * is_alive, render_mode mode = render_tiles);
+
+// keeps the scene and the accumulated image between calls,
+// so after a resize the picture is refined further instead of traced anew
+struct progressive_task
+{
+   progressive_task();
+   ~progressive_task();
+
+   // new scene, nothing accumulated
+   void reset();
+   bool render(framebuffer & fb, bool * is_alive);
+
+private:
+   scene_desc                desc_;
+   boost::scoped_ptr<tracer> tracer_;
+   progressive               prog_;
+};
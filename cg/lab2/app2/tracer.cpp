@@ -4,120 +4,186 @@
 #include "common.h"
 #include "fuzzy_refl.h"
 
-tracer::tracer()
+const double tracer::glossy_rel_err = 0.02;
+const double tracer::glossy_abs_err = 0.002;
+
+tracer::tracer( scene_desc const & desc )
+   : seed_(0)
+   , counters_(omp::get_max_threads())
 {
-   ::srand(GetTickCount());
-   load_scene();
+   reset_stats();
+   load_scene(desc);
 }
 
-colorf tracer::trace( point_3 origin, point_3 dir )
+colorf tracer::trace( point_3 origin, point_3 dir, rand_stream & rng ) const
 {
-   return do_trace(origin, dir, 1.);
+   return do_trace(origin, dir, 1., rng);
 }
 
-colorf tracer::do_trace( point_3 origin, point_3 dir, double weight )
+void tracer::trace( point_3 origin, point_3 const * dirs, colorf * res, rand_stream & rng ) const
 {
-   line_3 l(origin, dir, cg::line::by_direction);
-   optional<intersect_detail> closest_int;
-   optional<colorf> res_c;
-   object_ptr p;
-   for each (object_ptr const & testp in objs_)
+   point_3          origins[ray_packet::size];
+   prim_ref         prims[ray_packet::size];
+   intersect_detail details[ray_packet::size];
+
+   std::fill(origins, origins + ray_packet::size, origin);
+   closest_hit(origins, dirs, prims, details);
+
+   for (int i = 0; i != ray_packet::size; ++i)
+      res[i] = prims[i].valid() ? shade(prims[i], details[i], dirs[i], 1., rng) : cg::color_black();
+}
+
+void tracer::closest_hit( point_3 const * origins, point_3 const * dirs, prim_ref * prims, intersect_detail * details ) const
+{
+   count_rays(ray_packet::size);
+
+   if (!use_packets_)
    {
-      intersect_detail d;
-      if (testp->intersect_ray(l, &d) && (*d.t && (!closest_int || closest_int->t > *d.t)))
-      {
-         closest_int = d;
-         p = testp;
-      }
+      for (int i = 0; i != ray_packet::size; ++i)
+         prims[i] = bvh_.closest_hit(line_3(origins[i], dirs[i], cg::line::by_direction), details[i]);
+      return;
    }
 
-   if (closest_int)
+   packet_hit hit;
+   packets_.intersect(ray_packet(origins, dirs), hit);
+
+   for (int i = 0; i != ray_packet::size; ++i)
    {
-      intersect_detail d = *closest_int;
-      point_3 n = p->normal(d.pos);
-      material m = p->mat();
+      line_3 l(origins[i], dirs[i], cg::line::by_direction);
 
-      cg::colorf c = m.ka * (ambient_ & m.color);
-      for each (light const & li in ls_)
+      // the float test may have missed a grazing hit or picked the wrong one of two close primitives
+      if (hit.uncertain & (1 << i))
       {
-         bool visible = true;
+         prims[i] = bvh_.closest_hit(l, details[i]);
+         continue;
+      }
 
-         point_3 to_light = cg::normalized_safe(li.pos - d.pos);
-         double ln = (to_light * p->normal(d.pos));
-         if (ln < 0)
-            continue;
-         for each (object_ptr const & pp in objs_)
-         {
-            if (p == pp)
-               continue;
-            if (pp->intersect_seg(segment_3(d.pos, li.pos), NULL))
-            {
-               visible = false;
-               break;
-            }
-         }
+      prims[i] = prim_ref();
+      if (!(hit.mask & (1 << i)))
+         continue;
 
-         float spec = (float)(m.ks * li.shadow(d.pos) * pow((float)(n * (cg::normalized(li.pos - d.pos - dir))), (float)m.p));
-         if (visible)
-            c += 
-            (float)(li.shadow(d.pos) * m.kd * ln) * (li.color & m.color) + 
-            spec * (li.color);
-      }
+      // the packet only picks the primitive, the exact hit comes from the scene
+      prim_ref const p = packets_.ref(hit.idx[i]);
+      if (scene_.intersect_ray(p, l, &details[i]))
+         prims[i] = p;
+      else
+         prims[i] = bvh_.closest_hit(l, details[i]);
+   }
+}
 
-      double new_weight = m.kr * weight;
-      if (m.fuzzy_refl && cg::eq(weight, 1.0))
-      {
-         int const total_rays = 50;
-         int rays = 0;
-         new_weight /= total_rays;
-         fuzzy_refl_calc fc(-dir, d.n);
-         while (rays < total_rays)
-         {
-            point_3 new_dir = rand_vec();
-            double cs = new_dir * d.n;
-            if (cs < 0)
-               continue;
+bool tracer::occluded( segment_3 const & s, prim_ref skip ) const
+{
+   count_rays(1);
+   return bvh_.any_hit(s, skip);
+}
 
-            double p = fc(new_dir);
-            if (cg::rand(1.0) > p)
-               continue;
+colorf tracer::ambient_term( material const & m ) const
+{
+   return m.ka * (ambient_ & m.color);
+}
 
-            rays++;
-            c += do_trace(d.pos, new_dir, new_weight) * (float)new_weight;
-         }
-      }
-      else
+bool tracer::light_term( material const & m, intersect_detail const & d, point_3 const & n, point_3 const & dir, light const & li, colorf & res ) const
+{
+   point_3 to_light = cg::normalized_safe(li.pos - d.pos);
+   double ln = (to_light * n);
+   if (ln < 0)
+      return false;
+
+   float spec = (float)(m.ks * li.shadow(d.pos) * pow((float)(n * (cg::normalized(li.pos - d.pos - dir))), (float)m.p));
+   res = 
+      (float)(li.shadow(d.pos) * m.kd * ln) * (li.color & m.color) + 
+      spec * (li.color);
+   return true;
+}
+
+colorf tracer::do_trace( point_3 origin, point_3 dir, double weight, rand_stream & rng ) const
+{
+   count_rays(1);
+
+   line_3 l(origin, dir, cg::line::by_direction);
+   intersect_detail d;
+   prim_ref p = bvh_.closest_hit(l, d);
+
+   return p.valid() ? shade(p, d, dir, weight, rng) : cg::color_black();
+}
+
+colorf tracer::shade( prim_ref p, intersect_detail const & d, point_3 dir, double weight, rand_stream & rng ) const
+{
+   point_3 const & n = d.n;
+   material const & m = scene_.mat(p);
+
+   cg::colorf c = ambient_term(m);
+   for (size_t i = 0; i != ls_.size(); ++i)
+   {
+      light const & li = ls_[i];
+      colorf lc;
+      if (light_term(m, d, n, dir, li, lc) && !occluded(segment_3(d.pos, li.pos), p))
+         c += lc;
+   }
+
+   double new_weight = m.kr * weight;
+   if (m.fuzzy_refl && d.reflect && cg::eq(weight, 1.0))
+   {
+      // the lobe shares the exponent with the highlight, directions under the surface are absorbed
+      // samples are drawn in batches until the pixel estimate settles
+      glossy_lobe lobe(*d.reflect, m.p);
+      sample_stats stats;
+      double const sample_weight = new_weight / glossy_min_samples;
+      while (stats.count() < glossy_max_samples)
       {
-         if (d.reflect && new_weight > 0.1)
-            c += do_trace(d.pos, *d.reflect, new_weight) * (float)new_weight;
+         for (int i = 0; i != glossy_batch; ++i)
+         {
+            double const u1 = rng.uniform();
+            point_3 new_dir = lobe.sample(u1, rng.uniform());
+            stats.add(new_dir * d.n > 0 ? do_trace(d.pos, new_dir, sample_weight, rng) : cg::color_black());
+         }
+
+         if (stats.count() >= glossy_min_samples && stats.converged(glossy_rel_err, glossy_abs_err))
+            break;
       }
 
-      res_c = c;
+      c += stats.mean() * (float)new_weight;
+   }
+   else
+   {
+      if (d.reflect && new_weight > 0.1)
+         c += do_trace(d.pos, *d.reflect, new_weight, rng) * (float)new_weight;
    }
 
-   return res_c ? *res_c : cg::color_black();
+   return c;
 }
 
-void tracer::load_scene()
+boost::int64_t tracer::rays_count() const
 {
-   //object_ptr plane(new plane_obj(cg::normalized(point_3(0, 0, 1)), point_3(0, 0, -3)));
-   ////plane->mat().kr = 0;
-   ////plane->mat().fuzzy_refl = true;
-   //objs_.push_back(plane);
+   boost::int64_t res = 0;
+   for (size_t i = 0; i != counters_.size(); ++i)
+      res += counters_[i].rays;
+   return res;
+}
 
-   object_ptr s(new sphere_obj(point_3(0, 5, 1), 2));
-   //s->mat().fuzzy_refl = true;
-   s->mat().color = cg::color_yellow();
-   objs_.push_back(s);
+void tracer::reset_stats()
+{
+   for (size_t i = 0; i != counters_.size(); ++i)
+      counters_[i].rays = 0;
+}
 
+void tracer::count_rays( int n ) const
+{
+   // teams wider than omp_get_max_threads() at construction share slots and may lose counts
+   counters_[omp::get_thread_num() % counters_.size()].rays += n;
+}
 
-   object_ptr s2(new sphere_obj(point_3(5, 5, 3), 2));
-   s2->mat().fuzzy_refl = true;
-   s->mat().color = cg::color_darkgray();
-   objs_.push_back(s2);
+void tracer::load_scene( scene_desc const & desc )
+{
+   // objects are only a convenient way to describe the scene, their materials are copied on add
+   for (size_t i = 0; i != desc.objs.size(); ++i)
+      scene_.add(desc.objs[i]);
 
+   ls_ = desc.ls;
+   ambient_ = desc.ambient;
 
-   ls_.push_back(light(point_3(3, 0, 1), colorf(1, 1, 1), 1));
+   bvh_.build(scene_);
 
-   ambient_ = cg::color_white();
-}
\ No newline at end of file
+   // a flat packet loop only beats the bvh on small scenes
+   use_packets_ = packets_.build(scene_) && packets_.size() <= packet_max_objects;
+}
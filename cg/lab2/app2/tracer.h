@@ -1,20 +1,75 @@
 #pragma once
 
-#include "object.h"
+#include "scene.h"
 #include "light.h"
+#include "bvh.h"
+#include "packet.h"
+#include "scene_file.h"
+#include "common/rand_stream.h"
 
 struct tracer
 {
-   tracer();
-   colorf trace(point_3 origin, point_3 dir);
+   // scenes with more objects than this are traced through the bvh only
+   static const size_t packet_max_objects = 32;
+
+   // adaptive sampling of glossy reflections
+   static const int glossy_batch       = 4;
+   static const int glossy_min_samples = 8;
+   static const int glossy_max_samples = 64;
+   static const double glossy_rel_err;
+   static const double glossy_abs_err;
+
+   explicit tracer(scene_desc const & desc);
+
+   // may be called concurrently, the scene is read-only after construction
+   // rng feeds the Monte-Carlo parts, a caller keying it by pixel gets images independent of threading
+   colorf trace(point_3 origin, point_3 dir, rand_stream & rng) const;
+   // traces ray_packet::size rays from a common origin, uses SSE packets on small scenes
+   void trace(point_3 origin, point_3 const * dirs, colorf * res, rand_stream & rng) const;
+
+   // base seed the renderers mix into their per-pixel streams
+   boost::uint64_t seed() const { return seed_; }
+   void set_seed(boost::uint64_t seed) { seed_ = seed; }
+
+   // building blocks of trace(), for schedulers that batch rays themselves (see wavefront.h)
+
+   // closest hits of ray_packet::size rays, prims[i] is invalid where ray i hits nothing
+   void closest_hit(point_3 const * origins, point_3 const * dirs, prim_ref * prims, intersect_detail * details) const;
+   bool occluded(segment_3 const & s, prim_ref skip) const;
+
+   material const & mat(prim_ref r) const { return scene_.mat(r); }
+
+   colorf ambient_term(material const & m) const;
+   // what li adds at the hit if nothing occludes it, false if the surface faces away from li
+   bool light_term(material const & m, intersect_detail const & d, point_3 const & n, point_3 const & dir, light const & li, colorf & res) const;
+
+   lights const & scene_lights() const { return ls_; }
+
+   // rays cast since construction or reset_stats(), shadow rays included
+   boost::int64_t rays_count() const;
+   void reset_stats();
 
 private:
-   colorf do_trace(point_3 origin, point_3 dir, double weight);
-   void load_scene();
+   colorf do_trace(point_3 origin, point_3 dir, double weight, rand_stream & rng) const;
+   colorf shade(prim_ref p, intersect_detail const & d, point_3 dir, double weight, rand_stream & rng) const;
+   void load_scene(scene_desc const & desc);
+   void count_rays(int n) const;
 
 private:
-   objects objs_;
+   scene scene_;
+   scene_bvh bvh_;
+   packet_scene packets_;
+   bool use_packets_;
    lights ls_;
    point_3 point_source_;
    cg::colorf ambient_;
+   boost::uint64_t seed_;
+
+   // one cache line per thread, so counting doesn't make the threads fight over memory
+   struct ray_counter
+   {
+      boost::int64_t rays;
+      char           pad[64 - sizeof(boost::int64_t)];
+   };
+   mutable std::vector<ray_counter> counters_;
 };
@@ -0,0 +1,258 @@
+#include "stdafx.h"
+
+#include "wavefront.h"
+#include "tracer.h"
+#include "fuzzy_refl.h"
+
+namespace
+{
+   struct wave_ray
+   {
+      point_3 org;
+      point_3 dir;
+      double  weight;     // what the depth-first tracer passes down as weight
+      float   throughput; // share of the pixel this ray's color goes to
+      int     pixel;
+   };
+
+   struct shadow_ray
+   {
+      point_3        from;
+      point_3        to;
+      prim_ref       skip;
+      colorf         contrib; // added to the pixel if nothing occludes the segment
+      int            pixel;
+   };
+
+   // 10 bits per axis interleaved
+   unsigned spread_bits( unsigned v )
+   {
+      v &= 0x3ff;
+      v = (v | (v << 16)) & 0x030000ff;
+      v = (v | (v <<  8)) & 0x0300f00f;
+      v = (v | (v <<  4)) & 0x030c30c3;
+      v = (v | (v <<  2)) & 0x09249249;
+      return v;
+   }
+
+   // direction octant on top, morton code of the origin inside the queue bounds below
+   template <class Ray>
+   void sort_queue( std::vector<Ray> & rays, point_3 (*origin)(Ray const &), point_3 (*dir)(Ray const &) )
+   {
+      if (rays.size() < 2)
+         return;
+
+      rectangle_3 bound;
+      for (size_t i = 0; i != rays.size(); ++i)
+         bound |= origin(rays[i]);
+
+      point_3 const lo = bound.lo();
+      point_3 const size = bound.size();
+
+      std::vector<std::pair<unsigned, int> > keys(rays.size());
+      for (size_t i = 0; i != rays.size(); ++i)
+      {
+         point_3 const o = origin(rays[i]);
+         point_3 const d = dir(rays[i]);
+
+         unsigned cell[3];
+         for (size_t k = 0; k != 3; ++k)
+            cell[k] = size[k] > 0 ? cg::min((unsigned)((o[k] - lo[k]) / size[k] * 512), 511u) : 0;
+
+         unsigned octant = (d.x < 0 ? 1 : 0) | (d.y < 0 ? 2 : 0) | (d.z < 0 ? 4 : 0);
+         keys[i] = std::make_pair(
+            (octant << 27) | (spread_bits(cell[0]) | (spread_bits(cell[1]) << 1) | (spread_bits(cell[2]) << 2)), (int)i);
+      }
+
+      std::sort(keys.begin(), keys.end());
+
+      std::vector<Ray> sorted(rays.size());
+      for (size_t i = 0; i != keys.size(); ++i)
+         sorted[i] = rays[keys[i].second];
+      rays.swap(sorted);
+   }
+
+   point_3 ray_origin( wave_ray const & r ) { return r.org; }
+   point_3 ray_dir   ( wave_ray const & r ) { return r.dir; }
+
+   point_3 shadow_origin( shadow_ray const & r ) { return r.from; }
+   point_3 shadow_dir   ( shadow_ray const & r ) { return r.to - r.from; }
+
+   template <class T>
+   void append_all( std::vector<std::vector<T> > & parts, std::vector<T> & dst )
+   {
+      dst.clear();
+      for (size_t i = 0; i != parts.size(); ++i)
+      {
+         dst.insert(dst.end(), parts[i].begin(), parts[i].end());
+         parts[i].clear();
+      }
+   }
+}
+
+wavefront::wavefront( int chunk_pixels, int threads )
+   : chunk_pixels_(cg::max(chunk_pixels, (int)ray_packet::size))
+   , threads_(threads > 0 ? threads : omp::get_max_threads())
+{
+}
+
+bool wavefront::render( tracer const & tr, screen_camera const & cam, framebuffer & fb, bool const * alive ) const
+{
+   Assert(fb.width() == cam.width() && fb.height() == cam.height());
+
+   int const pixels = fb.width() * fb.height();
+   for (int first = 0; first < pixels; first += chunk_pixels_)
+      if (!render_chunk(tr, cam, fb, first, cg::min(first + chunk_pixels_, pixels), alive))
+         return false;
+
+   return *alive;
+}
+
+bool wavefront::render_chunk( tracer const & tr, screen_camera const & cam, framebuffer & fb, int first, int last, bool const * alive ) const
+{
+   int const w = fb.width();
+
+   std::vector<colorf> accum(last - first, cg::color_black());
+
+   std::vector<wave_ray> rays(last - first);
+   for (int i = first; i != last; ++i)
+   {
+      wave_ray & r = rays[i - first];
+      r.org = cam.origin();
+      r.dir = cam.ray_dir(i % w, i / w);
+      r.weight = 1.;
+      r.throughput = 1.f;
+      r.pixel = i - first;
+   }
+
+   std::vector<std::vector<wave_ray> >   next_parts(threads_);
+   std::vector<std::vector<shadow_ray> > shadow_parts(threads_);
+   std::vector<shadow_ray>               shadows;
+
+   for (unsigned wave = 0; !rays.empty(); ++wave)
+   {
+      if (!*alive)
+         return false;
+
+      sort_queue(rays, &ray_origin, &ray_dir);
+
+      int const n = (int)rays.size();
+      int const groups = (n + ray_packet::size - 1) / ray_packet::size;
+
+      std::vector<prim_ref>         prims(groups * ray_packet::size);
+      std::vector<intersect_detail> details(groups * ray_packet::size);
+      std::vector<colorf>           local(n);
+
+      // closest hits, packet by packet; the tail packet repeats the last ray
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16) num_threads(threads_)
+#endif
+      for (int g = 0; g < groups; ++g)
+      {
+         point_3 orgs[ray_packet::size], dirs[ray_packet::size];
+         for (int k = 0; k != ray_packet::size; ++k)
+         {
+            wave_ray const & r = rays[cg::min(g * ray_packet::size + k, n - 1)];
+            orgs[k] = r.org;
+            dirs[k] = r.dir;
+         }
+
+         tr.closest_hit(orgs, dirs, &prims[g * ray_packet::size], &details[g * ray_packet::size]);
+      }
+
+      // local shading, emits shadow rays and the next bounce
+      // static schedule keeps the per-thread outputs in queue order
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads_)
+#endif
+      for (int i = 0; i < n; ++i)
+      {
+         local[i] = cg::color_black();
+         if (!prims[i].valid())
+            continue;
+
+         std::vector<wave_ray>   & next    = next_parts  [omp::get_thread_num()];
+         std::vector<shadow_ray> & out     = shadow_parts[omp::get_thread_num()];
+
+         wave_ray const & r = rays[i];
+         intersect_detail const & d = details[i];
+         material const & m = tr.mat(prims[i]);
+
+         local[i] = tr.ambient_term(m);
+
+         for (size_t l = 0; l != tr.scene_lights().size(); ++l)
+         {
+            light const & li = tr.scene_lights()[l];
+            shadow_ray s;
+            if (!tr.light_term(m, d, d.n, r.dir, li, s.contrib))
+               continue;
+
+            s.from = d.pos;
+            s.to = li.pos;
+            s.skip = prims[i];
+            s.contrib = s.contrib * r.throughput;
+            s.pixel = r.pixel;
+            out.push_back(s);
+         }
+
+         // same rules as tracer::shade
+         double const new_weight = m.kr * r.weight;
+         if (m.fuzzy_refl && d.reflect && cg::eq(r.weight, 1.0))
+         {
+            // queue order doesn't depend on the threads, so neither does the key
+            rand_stream rng(tr.seed(), ((boost::uint64_t)first << 32) | (unsigned)i, wave);
+            glossy_lobe lobe(*d.reflect, m.p);
+            for (int k = 0; k != glossy_samples; ++k)
+            {
+               wave_ray g;
+               double const u1 = rng.uniform();
+               g.dir = lobe.sample(u1, rng.uniform());
+               if (g.dir * d.n <= 0)
+                  continue;
+
+               g.org = d.pos;
+               g.weight = new_weight / tracer::glossy_min_samples;
+               g.throughput = (float)(r.throughput * new_weight / glossy_samples);
+               g.pixel = r.pixel;
+               next.push_back(g);
+            }
+         }
+         else if (d.reflect && new_weight > 0.1)
+         {
+            wave_ray g;
+            g.org = d.pos;
+            g.dir = *d.reflect;
+            g.weight = new_weight;
+            g.throughput = (float)(r.throughput * new_weight);
+            g.pixel = r.pixel;
+            next.push_back(g);
+         }
+      }
+
+      for (int i = 0; i != n; ++i)
+         accum[rays[i].pixel] += local[i] * rays[i].throughput;
+
+      append_all(shadow_parts, shadows);
+      sort_queue(shadows, &shadow_origin, &shadow_dir);
+
+      int const shadows_count = (int)shadows.size();
+      std::vector<char> visible(shadows_count);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64) num_threads(threads_)
+#endif
+      for (int i = 0; i < shadows_count; ++i)
+         visible[i] = !tr.occluded(segment_3(shadows[i].from, shadows[i].to), shadows[i].skip);
+
+      for (int i = 0; i != shadows_count; ++i)
+         if (visible[i])
+            accum[shadows[i].pixel] += shadows[i].contrib;
+
+      append_all(next_parts, rays);
+   }
+
+   for (int i = first; i != last; ++i)
+      fb(i % w, i / w) = accum[i - first];
+
+   return true;
+}
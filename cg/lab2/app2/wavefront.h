@@ -0,0 +1,30 @@
+#pragma once
+
+#include "framebuffer.h"
+#include "screen_camera.h"
+
+struct tracer;
+
+// Breadth-first alternative to render_engine.
+// The frame is traced in chunks of pixels; every bounce of a chunk is one queue
+// (primary, shadow, reflection and glossy rays) processed as a whole by all threads.
+// Before traversal a queue is sorted by direction octant and origin, so neighbouring
+// rays walk the same bvh nodes, and ray and shadow queries go in packets.
+struct wavefront
+{
+   // threads == 0 means one thread per core
+   explicit wavefront(int chunk_pixels = 1 << 16, int threads = 0);
+
+   // same contract as render_engine::render, alive is polled between waves
+   bool render(tracer const & tr, screen_camera const & cam, framebuffer & fb, bool const * alive) const;
+
+   // glossy lobes get a fixed sample count here, adaptive stopping needs the whole subtree of a sample
+   static const int glossy_samples = 16;
+
+private:
+   bool render_chunk(tracer const & tr, screen_camera const & cam, framebuffer & fb, int first, int last, bool const * alive) const;
+
+private:
+   int chunk_pixels_;
+   int threads_;
+};
@@ -0,0 +1,253 @@
+// Headless render benchmark for the app2 tracer.
+//
+//    bench [options] scene...
+//
+// A scene is a scene file (see app2/scene_file.h) or "default" for the scene app2 shows.
+// Every scene is loaded, built and rendered with the same seed, the best of the repeats
+// is reported along with the speedup against a baseline saved by an earlier run.
+//
+// Windows only for now. The bench itself and the app2 sources it compiles are standard C++
+// and OpenMP, but the shared Include/ headers are not: backslash and case-insensitive include
+// paths, __forceinline, and templates that rely on MSVC's delayed parsing (rectangle.h,
+// segment.h, color_hsv.h, common/Assert.h). A Linux CI build needs those ported first.
+
+#include "stdafx.h"
+
+#include <map>
+
+#include "scene_file.h"
+#include "tracer.h"
+#include "render_engine.h"
+#include "wavefront.h"
+#include "progressive.h"
+
+namespace
+{
+   struct options
+   {
+      options()
+         : width(640), height(480), mode("tiles"), seed(1), repeats(3), threads(0), samples(16)
+      {}
+
+      int         width;
+      int         height;
+      std::string mode;     // tiles, wavefront or progressive
+      unsigned    seed;
+      int         repeats;
+      int         threads;
+      int         samples;  // per pixel, progressive only
+      std::string out_dir;  // images go here when set
+      std::string baseline; // compare against
+      std::string save;     // store this run as a baseline
+
+      std::vector<std::string> scenes;
+   };
+
+   struct result
+   {
+      double load;
+      double build;
+      double render;
+      double rays_per_sec;
+   };
+
+   // baseline entries are keyed by scene, mode and size
+   typedef std::map<std::string, result> results;
+
+   double now()
+   {
+#ifdef _OPENMP
+      return omp_get_wtime();
+#else
+      return (double)clock() / CLOCKS_PER_SEC;
+#endif
+   }
+
+   void usage()
+   {
+      printf(
+         "usage: bench [options] scene...\n"
+         "   -w N           image width (640)\n"
+         "   -h N           image height (480)\n"
+         "   -m MODE        tiles, wavefront or progressive (tiles)\n"
+         "   -spp N         samples per pixel for progressive (16)\n"
+         "   -seed N        random seed (1)\n"
+         "   -r N           repeats, the best one counts (3)\n"
+         "   -t N           threads, 0 is one per core (0)\n"
+         "   -o DIR         write DIR/<scene>.ppm and .pfm\n"
+         "   -baseline FILE compare with a saved run\n"
+         "   -save FILE     save this run as a baseline\n"
+         "scene is a scene file or \"default\"\n");
+   }
+
+   bool parse_args( int argc, char ** argv, options & opt )
+   {
+      for (int i = 1; i < argc; ++i)
+      {
+         std::string const arg = argv[i];
+         if (arg[0] != '-')
+         {
+            opt.scenes.push_back(arg);
+            continue;
+         }
+
+         if (i + 1 == argc)
+            return false;
+
+         char const * val = argv[++i];
+         if      (arg == "-w"       ) opt.width   = atoi(val);
+         else if (arg == "-h"       ) opt.height  = atoi(val);
+         else if (arg == "-m"       ) opt.mode    = val;
+         else if (arg == "-spp"     ) opt.samples = atoi(val);
+         else if (arg == "-seed"    ) opt.seed    = (unsigned)atoi(val);
+         else if (arg == "-r"       ) opt.repeats = atoi(val);
+         else if (arg == "-t"       ) opt.threads = atoi(val);
+         else if (arg == "-o"       ) opt.out_dir = val;
+         else if (arg == "-baseline") opt.baseline = val;
+         else if (arg == "-save"    ) opt.save    = val;
+         else
+            return false;
+      }
+
+      return !opt.scenes.empty() && opt.width > 0 && opt.height > 0 && opt.repeats > 0
+         && (opt.mode == "tiles" || opt.mode == "wavefront" || opt.mode == "progressive");
+   }
+
+   std::string scene_name( std::string const & path )
+   {
+      size_t const slash = path.find_last_of("/\\");
+      std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+      return name.substr(0, name.find('.'));
+   }
+
+   std::string result_key( std::string const & name, options const & opt )
+   {
+      std::ostringstream key;
+      key << name << " " << opt.mode << " " << opt.width << "x" << opt.height;
+      return key.str();
+   }
+
+   // one "name mode WxH load build render rays_per_sec" line per result
+   void load_results( std::string const & path, results & res )
+   {
+      std::ifstream in(path.c_str());
+      std::string name, mode, size;
+      result r;
+      while (in >> name >> mode >> size >> r.load >> r.build >> r.render >> r.rays_per_sec)
+         res[name + " " + mode + " " + size] = r;
+   }
+
+   bool save_results( std::string const & path, results const & res )
+   {
+      std::ofstream out(path.c_str());
+      for (results::const_iterator it = res.begin(); it != res.end(); ++it)
+         out << it->first << " " << it->second.load << " " << it->second.build << " "
+             << it->second.render << " " << it->second.rays_per_sec << "\n";
+      return !!out;
+   }
+
+   bool render( tracer const & tr, screen_camera const & cam, framebuffer & fb, options const & opt )
+   {
+      bool const alive = true;
+      if (opt.mode == "wavefront")
+         return wavefront(1 << 16, opt.threads).render(tr, cam, fb, &alive);
+      if (opt.mode == "progressive")
+         return progressive(opt.samples, opt.threads).render(tr, cam, fb, &alive);
+      return render_engine(32, opt.threads).render(tr, cam, fb, &alive);
+   }
+}
+
+int main( int argc, char ** argv )
+{
+   options opt;
+   if (!parse_args(argc, argv, opt))
+   {
+      usage();
+      return 1;
+   }
+
+#ifdef _OPENMP
+   if (opt.threads > 0)
+      omp_set_num_threads(opt.threads);
+#endif
+
+   results baseline, current;
+   if (!opt.baseline.empty())
+      load_results(opt.baseline, baseline);
+
+   printf("%-24s %9s %9s %9s %10s %8s\n", "scene", "load ms", "build ms", "render ms", "Mrays/s", "speedup");
+
+   for (size_t s = 0; s != opt.scenes.size(); ++s)
+   {
+      std::string const & path = opt.scenes[s];
+      std::string const name = scene_name(path);
+
+      // material colors come from rand() too, so the seed goes first
+      srand(opt.seed);
+
+      double t = now();
+      scene_desc desc;
+      std::string error;
+      if (path == "default")
+         desc = default_scene();
+      else if (!load_scene_file(path, desc, error))
+      {
+         fprintf(stderr, "%s\n", error.c_str());
+         return 1;
+      }
+
+      result r;
+      r.load = now() - t;
+
+      t = now();
+      tracer tr(desc);
+      tr.set_seed(opt.seed);
+      r.build = now() - t;
+
+      screen_camera cam(desc.cam_origin, desc.cam_dir, desc.cam_fov, opt.width, opt.height);
+      framebuffer fb(opt.width, opt.height);
+
+      r.render = std::numeric_limits<double>::max();
+      r.rays_per_sec = 0;
+      for (int i = 0; i != opt.repeats; ++i)
+      {
+         tr.reset_stats();
+
+         t = now();
+         render(tr, cam, fb, opt);
+         double const elapsed = now() - t;
+
+         if (elapsed < r.render)
+         {
+            r.render = elapsed;
+            r.rays_per_sec = tr.rays_count() / elapsed;
+         }
+      }
+
+      std::string const key = result_key(name, opt);
+      current[key] = r;
+
+      char speedup[32] = "-";
+      results::const_iterator base = baseline.find(key);
+      if (base != baseline.end())
+         sprintf(speedup, "%.2fx", base->second.render / r.render);
+
+      printf("%-24s %9.1f %9.1f %9.1f %10.2f %8s\n", name.c_str(),
+         r.load * 1e3, r.build * 1e3, r.render * 1e3, r.rays_per_sec * 1e-6, speedup);
+
+      if (!opt.out_dir.empty())
+      {
+         std::string const out = opt.out_dir + "/" + name;
+         if (!fb.write_ppm(out + ".ppm") || !fb.write_pfm(out + ".pfm"))
+            fprintf(stderr, "can't write %s.ppm/.pfm\n", out.c_str());
+      }
+   }
+
+   if (!opt.save.empty() && !save_results(opt.save, current))
+   {
+      fprintf(stderr, "can't write %s\n", opt.save.c_str());
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,125 @@
+// Benchmarks for the geometry library.
+//
+//    geom_bench [options] name...
+//
+// Runs the named benchmarks, or all of them. Each prints its own table.
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "geom_bench.h"
+
+namespace
+{
+   struct bench_entry
+   {
+      char const * name;
+      void      (* run)( bench_options const & );
+   };
+
+   bench_entry const benches[] =
+   {
+      { "layouts",    &bench_layouts    },
+      { "mapped",     &bench_mapped     },
+      { "overlay",    &bench_overlay    },
+      { "points",     &bench_points     },
+      { "predicates", &bench_predicates },
+      { "segments",   &bench_segments   },
+   };
+
+   size_t const benches_count = sizeof(benches) / sizeof(benches[0]);
+
+   void usage()
+   {
+      printf(
+         "usage: geom_bench [options] [name...]\n"
+         "   -n N     problem size multiplier (1)\n"
+         "   -seed N  random seed (1)\n"
+         "   -r N     repeats, the best one counts (3)\n"
+         "   -t N     threads, 0 is one per core (0)\n"
+         "names:");
+      for (size_t i = 0; i != benches_count; ++i)
+         printf(" %s", benches[i].name);
+      printf("\n");
+   }
+}
+
+double now()
+{
+#ifdef _OPENMP
+   return omp_get_wtime();
+#else
+   return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+int main( int argc, char ** argv )
+{
+   bench_options opt;
+   std::vector<std::string> names;
+
+   for (int i = 1; i < argc; ++i)
+   {
+      std::string const arg = argv[i];
+      if (arg[0] != '-')
+      {
+         names.push_back(arg);
+         continue;
+      }
+
+      if (i + 1 == argc)
+      {
+         usage();
+         return 1;
+      }
+
+      char const * val = argv[++i];
+      if      (arg == "-n"   ) opt.scale   = atoi(val);
+      else if (arg == "-seed") opt.seed    = (unsigned)atoi(val);
+      else if (arg == "-r"   ) opt.repeats = atoi(val);
+      else if (arg == "-t"   ) opt.threads = atoi(val);
+      else
+      {
+         usage();
+         return 1;
+      }
+   }
+
+   bool known = true;
+   for (size_t i = 0; i != names.size(); ++i)
+   {
+      bool found = false;
+      for (size_t j = 0; j != benches_count; ++j)
+         found |= names[i] == benches[j].name;
+      known &= found;
+   }
+
+   if (!known || opt.scale <= 0 || opt.repeats <= 0)
+   {
+      usage();
+      return 1;
+   }
+
+#ifdef _OPENMP
+   if (opt.threads > 0)
+      omp_set_num_threads(opt.threads);
+#endif
+
+   for (size_t i = 0; i != benches_count; ++i)
+   {
+      if (!names.empty() && std::find(names.begin(), names.end(), benches[i].name) == names.end())
+         continue;
+
+      printf("== %s\n", benches[i].name);
+      benches[i].run(opt);
+      printf("\n");
+   }
+
+   return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// Shared bits of the geometry benchmarks, one bench_xxx function per data structure.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+struct bench_options
+{
+   bench_options()
+      : scale(1), seed(1), repeats(3), threads(0)
+   {}
+
+   int      scale;   // problem size multiplier
+   unsigned seed;
+   int      repeats; // the best one counts
+   int      threads; // 0 is one per core
+};
+
+// seconds, wall clock
+double now();
+
+// best of opt.repeats runs of f(), in milliseconds
+template <class F>
+   double best_time( bench_options const & opt, F f )
+{
+   double best = 1e30;
+   for (int i = 0; i != opt.repeats; ++i)
+   {
+      double const t = now();
+      f();
+      best = std::min(best, (now() - t) * 1000);
+   }
+   return best;
+}
+
+// array_2d memory layouts (extents::rowwise, tiled, morton) under the Grid2L visitors
+void bench_layouts( bench_options const & opt );
+
+// Grid2L saved as a flat image and mapped back as MappedGrid2L
+void bench_mapped( bench_options const & opt );
+
+// pslg::overlay_parallel against the serial overlay, with a diff of the results
+void bench_overlay( bench_options const & opt );
+
+// point lookups one at a time against grid2l_points_batch
+void bench_points( bench_options const & opt );
+
+// orientation through cgal_predicates and adaptive_predicates
+void bench_predicates( bench_options const & opt );
+
+// robust_segments_intersector serial against parallel, with a diff of the intersections
+void bench_segments( bench_options const & opt );
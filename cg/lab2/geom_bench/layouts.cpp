@@ -0,0 +1,245 @@
+// array_2d layouts under the standard Grid2L visitors.
+//
+// The same grid and the same queries are run with the small cells stored rowwise,
+// in 8x8 tiles and in 16x16 Z-order tiles. The checksums have to agree, only the
+// memory order differs.
+
+#include <cstdio>
+
+#include "Geometry/grid2L.h"
+#include "Geometry/Grid2L/visit_grid2l_by_circle.h"
+#include "common/rand_stream.h"
+
+#include "geom_bench.h"
+
+using namespace cg;
+
+namespace
+{
+   struct small_cell
+   {
+      small_cell() : value(0), hits(0) {}
+
+      float    value;
+      unsigned hits;
+      int      pad[2];
+   };
+
+   struct fixed_subdivision
+   {
+      explicit fixed_subdivision(point_2i const & ext) : ext(ext) {}
+      point_2i operator () (point_2i const &) const { return ext; }
+
+      point_2i ext;
+   };
+
+   struct skip_sides
+   {
+      template <class State, class Cell>
+         bool operator () (State const &, Cell &) { return false; }
+   };
+
+   template <class G>
+      struct sum_processor : grid2l_visitor_base<G, sum_processor<G> >
+   {
+      sum_processor() : sum(0) {}
+
+      template <class State>
+         bool operator () (State const &, small_cell & cell)
+      {
+         sum += cell.value;
+         ++cell.hits;
+         return false;
+      }
+
+      typedef skip_sides SideProcessor;
+      SideProcessor & side_processor(int, int) { return sides_; }
+
+      double sum;
+
+   private:
+      skip_sides sides_;
+   };
+
+   struct queries
+   {
+      std::vector<rectangle_2> rects;
+      std::vector<triangle_2>  triangles;
+      std::vector<point_2>     centers;
+      std::vector<double>      radii;
+   };
+
+   // in grid units, the grid spans [0, big) x [0, big)
+   void make_queries( bench_options const & opt, int big, queries & q )
+   {
+      rand_stream rng(opt.seed);
+      int const count = 20000 * opt.scale;
+
+      for (int i = 0; i != count; ++i)
+      {
+         point_2 const c(rng.uniform() * big, rng.uniform() * big);
+         double  const r = 0.25 + 1.5 * rng.uniform();
+
+         q.rects.push_back(rectangle_2(c - point_2(r, r), c + point_2(r, r)));
+         q.triangles.push_back(triangle_2(
+            c + point_2(-r, -r), c + point_2(r, -r * rng.uniform()), c + point_2(r * rng.uniform(), r)));
+
+         if (i % 4 == 0)
+         {
+            q.centers.push_back(c);
+            q.radii.push_back(r);
+         }
+      }
+   }
+
+   struct timing
+   {
+      double rects, triangles, circles, windows;
+      double checksum;
+   };
+
+   template <class G, class Query>
+      struct run_queries
+   {
+      run_queries(G & grid, std::vector<Query> const & q, double & sum)
+         : grid_(grid), q_(q), sum_(sum)
+      {}
+
+      void operator () () const
+      {
+         sum_processor<G> proc;
+         for (size_t i = 0; i != q_.size(); ++i)
+            visit(grid_, q_[i], proc);
+         sum_ = proc.sum;
+      }
+
+   private:
+      G                        & grid_;
+      std::vector<Query> const & q_;
+      double                   & sum_;
+   };
+
+   template <class G>
+      struct run_circles
+   {
+      run_circles(grid2l_by_circle::traits<G> & traits, queries const & q, double & sum)
+         : traits_(traits), q_(q), sum_(sum)
+      {}
+
+      void operator () () const
+      {
+         sum_processor<G> proc;
+         for (size_t i = 0; i != q_.centers.size(); ++i)
+            visit_grid2l_by_circle(traits_, q_.centers[i], q_.radii[i], proc);
+         sum_ = proc.sum;
+      }
+
+   private:
+      grid2l_by_circle::traits<G> & traits_;
+      queries const               & q_;
+      double                      & sum_;
+   };
+
+   // 48 x 48 windows, x outer like visit_grid2l_by_rectangle
+   template <class Array>
+      struct run_windows
+   {
+      run_windows(Array const & a, std::vector<point_2i> const & corners, double & sum)
+         : a_(a), corners_(corners), sum_(sum)
+      {}
+
+      void operator () () const
+      {
+         double sum = 0;
+         for (size_t i = 0; i != corners_.size(); ++i)
+         {
+            point_2i idx;
+            for (idx.x = corners_[i].x; idx.x != corners_[i].x + 48; ++idx.x)
+               for (idx.y = corners_[i].y; idx.y != corners_[i].y + 48; ++idx.y)
+                  sum += a_[idx];
+         }
+         sum_ = sum;
+      }
+
+   private:
+      Array                 const & a_;
+      std::vector<point_2i> const & corners_;
+      double                      & sum_;
+   };
+
+   template <class Dir>
+      timing time_grid( bench_options const & opt, queries const & q, int big, int small )
+   {
+      typedef Grid2L<small_cell, grid2l_bigcell<small_cell, Empty, Dir> > grid_type;
+
+      grid_type grid(point_2(0, 0), point_2(1, 1), point_2i(big, big));
+      grid.MakeSubdivision(fixed_subdivision(point_2i(small, small)));
+
+      // value depends on the position only, so the sums match between layouts
+      for (int bx = 0; bx != big; ++bx)
+         for (int by = 0; by != big; ++by)
+            for (int sx = 0; sx != small; ++sx)
+               for (int sy = 0; sy != small; ++sy)
+                  grid.at(point_2i(bx, by)).at(point_2i(sx, sy)).value = (float)((bx * 7 + by * 13 + sx * 3 + sy) & 63);
+
+      timing t;
+      double rect_sum = 0, tri_sum = 0, circle_sum = 0;
+
+      t.rects     = best_time(opt, run_queries<grid_type, rectangle_2>(grid, q.rects, rect_sum));
+      t.triangles = best_time(opt, run_queries<grid_type, triangle_2 >(grid, q.triangles, tri_sum));
+
+      grid2l_by_circle::traits<grid_type> circle_traits(grid);
+      t.circles   = best_time(opt, run_circles<grid_type>(circle_traits, q, circle_sum));
+
+      t.checksum = rect_sum + tri_sum + circle_sum;
+      return t;
+   }
+
+   // raw 2D windows over one large array, without the visitor around them
+   template <class Dir>
+      void time_windows( bench_options const & opt, int side, timing & t )
+   {
+      typedef array_2d<float, extents::rect, Dir> array_type;
+
+      array_type a(point_2i(side, side));
+      for (int y = 0; y != side; ++y)
+         for (int x = 0; x != side; ++x)
+            a[point_2i(x, y)] = (float)((x + 3 * y) & 31);
+
+      rand_stream rng(opt.seed);
+      std::vector<point_2i> corners(20000 * opt.scale);
+      for (size_t i = 0; i != corners.size(); ++i)
+         corners[i] = point_2i(int(rng.uniform() * (side - 48)), int(rng.uniform() * (side - 48)));
+
+      double sum = 0;
+      t.windows = best_time(opt, run_windows<array_type>(a, corners, sum));
+      t.checksum += sum;
+   }
+
+   template <class Dir>
+      void run_layout( char const * name, bench_options const & opt, queries const & q, int big, int small, int side )
+   {
+      timing t = time_grid<Dir>(opt, q, big, small);
+      time_windows<Dir>(opt, side, t);
+
+      printf("%-10s %10.1f %10.1f %10.1f %10.1f %16.0f\n", name, t.rects, t.triangles, t.circles, t.windows, t.checksum);
+   }
+}
+
+void bench_layouts( bench_options const & opt )
+{
+   int const big   = 64;
+   int const small = 32;
+   int const side  = 4096;
+
+   queries q;
+   make_queries(opt, big, q);
+
+   printf("%d x %d big cells of %d x %d, %d queries; %d x %d array, 48 x 48 windows\n",
+      big, big, small, small, (int)q.rects.size(), side, side);
+   printf("%-10s %10s %10s %10s %10s %16s\n", "layout", "rect ms", "tri ms", "circle ms", "window ms", "checksum");
+
+   run_layout<extents::rowwise   >("rowwise", opt, q, big, small, side);
+   run_layout<extents::tiled<>   >("tiled",   opt, q, big, small, side);
+   run_layout<extents::morton<>  >("morton",  opt, q, big, small, side);
+}
@@ -0,0 +1,182 @@
+// Grid2L saved with save_mapped_grid2l and mapped back as MappedGrid2L.
+//
+// Times saving, mapping and the first query on the mapped image, then runs the same
+// rectangle queries on both grids. The checksums have to agree.
+
+#include <cstdio>
+
+#include "Geometry/grid2L.h"
+#include "Geometry/Grid2L/Grid2L_MappedFile.h"
+#include "common/rand_stream.h"
+
+#include "geom_bench.h"
+
+using namespace cg;
+
+namespace
+{
+   struct small_cell
+   {
+      small_cell() : value(0), count(0) {}
+
+      float value;
+      int   count;
+   };
+
+   struct varying_subdivision
+   {
+      point_2i operator () (point_2i const & idx) const
+      {
+         // some big cells stay empty, as in real indices
+         int const n = (idx.x * 5 + idx.y * 3) % 17;
+         return n ? point_2i(n, 17 - n) : point_2i(0, 0);
+      }
+   };
+
+   struct skip_sides
+   {
+      template <class State, class Cell>
+         bool operator () (State const &, Cell &) { return false; }
+   };
+
+   template <class G>
+      struct sum_processor : grid2l_visitor_base<G, sum_processor<G> >
+   {
+      sum_processor() : sum(0) {}
+
+      template <class State>
+         bool operator () (State const &, small_cell const & cell)
+      {
+         sum += cell.value * cell.count;
+         return false;
+      }
+
+      typedef skip_sides SideProcessor;
+      SideProcessor & side_processor(int, int) { return sides_; }
+
+      double sum;
+
+   private:
+      skip_sides sides_;
+   };
+
+   template <class G>
+      struct run_rects
+   {
+      run_rects(G & grid, std::vector<rectangle_2> const & q, double & sum)
+         : grid_(grid), q_(q), sum_(sum)
+      {}
+
+      void operator () () const
+      {
+         sum_processor<G> proc;
+         for (size_t i = 0; i != q_.size(); ++i)
+            visit(grid_, q_[i], proc);
+         sum_ = proc.sum;
+      }
+
+   private:
+      G                              & grid_;
+      std::vector<rectangle_2> const & q_;
+      double                         & sum_;
+   };
+
+   template <class G>
+      struct save_grid
+   {
+      save_grid(G const & grid, char const * path, bool & ok)
+         : grid_(grid), path_(path), ok_(ok)
+      {}
+
+      void operator () () const { ok_ = save_mapped_grid2l(path_, grid_); }
+
+   private:
+      G const    & grid_;
+      char const * path_;
+      bool       & ok_;
+   };
+
+   // mapping plus one query, so that the header pages are really touched
+   struct open_grid
+   {
+      open_grid(char const * path, rectangle_2 const & r, double & sum)
+         : path_(path), r_(r), sum_(sum)
+      {}
+
+      void operator () () const
+      {
+         mapped_grid2l_file<small_cell> file(path_);
+         sum_processor<MappedGrid2L<small_cell> const> proc;
+         if (file)
+            visit(file.grid(), r_, proc);
+         sum_ = proc.sum;
+      }
+
+   private:
+      char const        * path_;
+      rectangle_2 const & r_;
+      double            & sum_;
+   };
+}
+
+void bench_mapped( bench_options const & opt )
+{
+   typedef Grid2L<small_cell>       grid_type;
+   typedef MappedGrid2L<small_cell> mapped_type;
+
+   int const    big  = 128 * opt.scale;
+   char const * path = "geom_bench_mapped.g2l";
+
+   grid_type grid(point_2(0, 0), point_2(1, 1), point_2i(big, big));
+   grid.MakeSubdivision(varying_subdivision());
+
+   rand_stream rng(opt.seed);
+   size_t cells = 0;
+   for (int bx = 0; bx != big; ++bx)
+      for (int by = 0; by != big; ++by)
+      {
+         grid_type::bigcell_type & bcell = grid.at(point_2i(bx, by));
+         if (!bcell)
+            continue;
+
+         for (grid_type::bigcell_type::iterator it = bcell.begin(); it != bcell.end(); ++it, ++cells)
+         {
+            it->value = rng.uniform();
+            it->count = (int)(cells % 5);
+         }
+      }
+
+   std::vector<rectangle_2> rects(20000 * opt.scale);
+   for (size_t i = 0; i != rects.size(); ++i)
+   {
+      point_2 const c(rng.uniform() * big, rng.uniform() * big);
+      double  const r = 0.25 + 1.5 * rng.uniform();
+      rects[i] = rectangle_2(c - point_2(r, r), c + point_2(r, r));
+   }
+
+   bool   saved    = false;
+   double open_sum = 0;
+   double const save_ms = best_time(opt, save_grid<grid_type>(grid, path, saved));
+   double const open_ms = best_time(opt, open_grid(path, rects[0], open_sum));
+
+   double grid_sum = 0, mapped_sum = 0, grid_ms = 0, mapped_ms = 0;
+   {
+      mapped_grid2l_file<small_cell> file(path);
+      if (!saved || !file)
+      {
+         printf("can't save or map %s\n", path);
+         return;
+      }
+
+      grid_ms   = best_time(opt, run_rects<grid_type        >(grid,        rects, grid_sum));
+      mapped_ms = best_time(opt, run_rects<mapped_type const>(file.grid(), rects, mapped_sum));
+   }
+
+   printf("%d x %d big cells, %d small cells, %d queries\n", big, big, (int)cells, (int)rects.size());
+   printf("save %.1f ms, map + first query %.3f ms\n", save_ms, open_ms);
+   printf("%-10s %10s %16s\n", "grid", "rect ms", "checksum");
+   printf("%-10s %10.1f %16.3f\n", "Grid2L", grid_ms,   grid_sum);
+   printf("%-10s %10.1f %16.3f\n", "mapped", mapped_ms, mapped_sum);
+
+   remove(path);
+}
@@ -0,0 +1,104 @@
+// pslg::overlay_parallel against the serial pslg::overlay.
+//
+// Two star-shaped polygons with many vertices, shifted so that their boundaries cross
+// everywhere. Every boolean operation runs both ways; the cycles have to be the same
+// up to the starting vertex and the order of cycles.
+
+#include <cstdio>
+#include <cmath>
+
+#include "Geometry/PSLG/pslg_overlay_parallel.h"
+#include "common/rand_stream.h"
+
+#include "geom_bench.h"
+
+using namespace cg;
+
+namespace
+{
+   typedef dcel::DCEL<double>            dcel_type;
+   typedef std::vector<point_2>          contour_type;
+   typedef std::vector<contour_type>     contours_type;
+
+   contour_type star( rand_stream & rng, point_2 const & c, double r, size_t n )
+   {
+      contour_type res(n);
+      for (size_t i = 0; i != n; ++i)
+      {
+         double const a  = 2 * 3.14159265358979323846 * i / n;
+         double const ri = r * (0.8 + 0.2 * rng.uniform());
+         res[i] = c + point_2(ri * cos(a), ri * sin(a));
+      }
+      return res;
+   }
+
+   // cycles started at their least vertex and sorted, so that equal results compare equal
+   contours_type normalized( dcel_type const & d )
+   {
+      contours_type res;
+      dcel::convertDCELToContour(res, d);
+
+      for (size_t i = 0; i != res.size(); ++i)
+         std::rotate(res[i].begin(), std::min_element(res[i].begin(), res[i].end()), res[i].end());
+
+      std::sort(res.begin(), res.end());
+      return res;
+   }
+
+   template <bool Parallel>
+      struct run_overlay
+   {
+      run_overlay(std::vector<dcel_type> const & in, BooleanOp op, dcel_type & res)
+         : in_(in), op_(op), res_(res)
+      {}
+
+      void operator () () const
+      {
+         dcel_type res;
+         if (Parallel)
+            pslg::overlay_parallel(res, in_.begin(), in_.end(), op_);
+         else
+            pslg::overlay(res, in_.begin(), in_.end(), op_);
+         res_ = res;
+      }
+
+   private:
+      std::vector<dcel_type> const & in_;
+      BooleanOp                      op_;
+      dcel_type                    & res_;
+   };
+}
+
+void bench_overlay( bench_options const & opt )
+{
+   size_t const n = 20000 * opt.scale;
+
+   rand_stream rng(opt.seed);
+
+   std::vector<dcel_type> in(2);
+   dcel::convertContourToDCEL(in[0], contours_type(1, star(rng, point_2(0, 0), 100, n)));
+   dcel::convertContourToDCEL(in[1], contours_type(1, star(rng, point_2(3, 1), 100, n)));
+
+   struct { BooleanOp op; char const * name; } const ops[] =
+   {
+      { BO_UNION,        "union"        },
+      { BO_INTERSECTION, "intersection" },
+      { BO_DIFFERENCE,   "difference"   },
+      { BO_XOR,          "xor"          },
+   };
+
+   printf("2 polygons of %d vertices\n", (int)n);
+   printf("%-14s %10s %10s %8s %s\n", "op", "serial ms", "strips ms", "cycles", "");
+   for (size_t i = 0; i != sizeof(ops) / sizeof(ops[0]); ++i)
+   {
+      dcel_type serial, parallel;
+      double const serial_ms   = best_time(opt, run_overlay<false>(in, ops[i].op, serial));
+      double const parallel_ms = best_time(opt, run_overlay<true >(in, ops[i].op, parallel));
+
+      contours_type const a = normalized(serial);
+      contours_type const b = normalized(parallel);
+
+      printf("%-14s %10.1f %10.1f %8d %s\n", ops[i].name, serial_ms, parallel_ms, (int)a.size(),
+         a == b ? "" : "MISMATCH");
+   }
+}
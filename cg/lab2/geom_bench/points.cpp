@@ -0,0 +1,140 @@
+// Point lookups one by one against grid2l_points_batch.
+//
+// The points come in random order, as height or material samples of a frame do.
+// All three runs have to give the same checksum.
+
+#include <cstdio>
+
+#include "Geometry/grid2L.h"
+#include "common/rand_stream.h"
+
+#include "geom_bench.h"
+
+using namespace cg;
+
+namespace
+{
+   typedef Grid2L<float> grid_type;
+
+   struct fixed_subdivision
+   {
+      explicit fixed_subdivision(point_2i const & ext) : ext(ext) {}
+      point_2i operator () (point_2i const &) const { return ext; }
+
+      point_2i ext;
+   };
+
+   struct skip_sides
+   {
+      template <class State, class Cell>
+         bool operator () (State const &, Cell &) { return false; }
+   };
+
+   struct lookup_processor : grid2l_visitor_base<grid_type, lookup_processor>
+   {
+      lookup_processor() : value(0) {}
+
+      template <class State>
+         bool operator () (State const &, float & cell)
+      {
+         value = cell;
+         return true;
+      }
+
+      typedef skip_sides SideProcessor;
+      SideProcessor & side_processor(int, int) { return sides_; }
+
+      float value;
+
+   private:
+      skip_sides sides_;
+   };
+
+   struct lookup
+   {
+      float operator () (point_2 const &, Index2L const &, float const & cell) const { return cell; }
+   };
+
+   double checksum(std::vector<float> const & v)
+   {
+      double sum = 0;
+      for (size_t i = 0; i != v.size(); ++i)
+         sum += v[i];
+      return sum;
+   }
+
+   struct run_single
+   {
+      run_single(grid_type & grid, std::vector<point_2> const & pts, std::vector<float> & out)
+         : grid_(grid), pts_(pts), out_(out)
+      {}
+
+      void operator () () const
+      {
+         for (size_t i = 0; i != pts_.size(); ++i)
+         {
+            lookup_processor proc;
+            visit(grid_, pts_[i], proc);
+            out_[i] = proc.value;
+         }
+      }
+
+   private:
+      grid_type                  & grid_;
+      std::vector<point_2> const & pts_;
+      std::vector<float>         & out_;
+   };
+
+   struct run_batch
+   {
+      run_batch(grid2l_points_batch<grid_type> & batch, std::vector<point_2> const & pts, std::vector<float> & out, bool parallel)
+         : batch_(batch), pts_(pts), out_(out), parallel_(parallel)
+      {}
+
+      void operator () () const
+      {
+         batch_(&pts_[0], pts_.size(), lookup(), &out_[0], parallel_);
+      }
+
+   private:
+      grid2l_points_batch<grid_type> & batch_;
+      std::vector<point_2> const     & pts_;
+      std::vector<float>             & out_;
+      bool                             parallel_;
+   };
+}
+
+void bench_points( bench_options const & opt )
+{
+   int const big   = 256;
+   int const small = 16;
+
+   grid_type grid(point_2(0, 0), point_2(1, 1), point_2i(big, big));
+   grid.MakeSubdivision(fixed_subdivision(point_2i(small, small)));
+
+   rand_stream rng(opt.seed);
+   for (int bx = 0; bx != big; ++bx)
+      for (int by = 0; by != big; ++by)
+      {
+         grid_type::bigcell_type & bcell = grid.at(point_2i(bx, by));
+         for (grid_type::bigcell_type::iterator it = bcell.begin(); it != bcell.end(); ++it)
+            *it = rng.uniform();
+      }
+
+   std::vector<point_2> pts(1000000 * opt.scale);
+   for (size_t i = 0; i != pts.size(); ++i)
+      pts[i] = point_2(rng.uniform() * big, rng.uniform() * big);
+
+   std::vector<float> single(pts.size()), batch(pts.size()), parallel(pts.size());
+   grid2l_points_batch<grid_type> points_batch(grid);
+
+   double const single_ms   = best_time(opt, run_single(grid, pts, single));
+   double const batch_ms    = best_time(opt, run_batch(points_batch, pts, batch,    false));
+   double const parallel_ms = best_time(opt, run_batch(points_batch, pts, parallel, true));
+
+   printf("%d x %d big cells of %d x %d, %d points\n", big, big, small, small, (int)pts.size());
+   printf("%-10s %10s %16s\n", "lookup", "ms", "checksum");
+   printf("%-10s %10.1f %16.3f\n", "single",   single_ms,   checksum(single));
+   printf("%-10s %10.1f %16.3f\n", "batch",    batch_ms,    checksum(batch));
+   printf("%-10s %10.1f %16.3f\n", "parallel", parallel_ms, checksum(parallel));
+}
@@ -0,0 +1,87 @@
+// Orientation tests through cgal_predicates and adaptive_predicates.
+//
+// Random triples are the easy case, nearly collinear ones (the third point rounded from
+// a point on the line) go to the exact stage. Both policies have to give the same counts.
+
+#include <cstdio>
+
+#include "Geometry/cgal_predicates.h"
+#include "common/rand_stream.h"
+
+#include "geom_bench.h"
+
+using namespace cg;
+
+namespace
+{
+   struct orientation_counts
+   {
+      orientation_counts() { counts[0] = counts[1] = counts[2] = 0; }
+
+      bool operator == (orientation_counts const & other) const
+      {
+         return counts[0] == other.counts[0] && counts[1] == other.counts[1] && counts[2] == other.counts[2];
+      }
+
+      int counts[3]; // by VecOrientation
+   };
+
+   template <class Predicates>
+      struct run_orientation
+   {
+      run_orientation(std::vector<point_2> const & pts, orientation_counts & res)
+         : pts_(pts), res_(res)
+      {}
+
+      void operator () () const
+      {
+         orientation_counts res;
+         for (size_t i = 0; i + 2 < pts_.size(); i += 3)
+            ++res.counts[Predicates::orientation(pts_[i], pts_[i + 1], pts_[i + 2])];
+         res_ = res;
+      }
+
+   private:
+      std::vector<point_2> const & pts_;
+      orientation_counts         & res_;
+   };
+
+   void run_set( bench_options const & opt, char const * name, std::vector<point_2> const & pts )
+   {
+      orientation_counts cgal, adaptive;
+      double const cgal_ms     = best_time(opt, run_orientation<cgal_predicates    >(pts, cgal));
+      double const adaptive_ms = best_time(opt, run_orientation<adaptive_predicates>(pts, adaptive));
+
+      printf("%-10s %10.1f %10.1f %8d %8d %8d %s\n", name, cgal_ms, adaptive_ms,
+         adaptive.counts[VO_LEFT], adaptive.counts[VO_RIGHT], adaptive.counts[VO_COLLINEAR],
+         cgal == adaptive ? "" : "MISMATCH");
+   }
+}
+
+void bench_predicates( bench_options const & opt )
+{
+   size_t const triples = 1000000 * opt.scale;
+
+   rand_stream rng(opt.seed);
+
+   std::vector<point_2> easy(triples * 3);
+   for (size_t i = 0; i != easy.size(); ++i)
+      easy[i] = point_2(rng.uniform() * 1000, rng.uniform() * 1000);
+
+   std::vector<point_2> hard(triples * 3);
+   for (size_t i = 0; i != hard.size(); i += 3)
+   {
+      point_2 const a(rng.uniform() * 1000, rng.uniform() * 1000);
+      point_2 const b(rng.uniform() * 1000, rng.uniform() * 1000);
+      double  const t = rng.uniform() * 2 - 0.5;
+
+      hard[i]     = a;
+      hard[i + 1] = b;
+      hard[i + 2] = a + (b - a) * t;
+   }
+
+   printf("%d triples\n", (int)triples);
+   printf("%-10s %10s %10s %8s %8s %8s\n", "input", "cgal ms", "adapt ms", "left", "right", "collin");
+   run_set(opt, "random",    easy);
+   run_set(opt, "collinear", hard);
+}
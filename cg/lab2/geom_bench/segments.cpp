@@ -0,0 +1,99 @@
+// robust_segments_intersector in serial and parallel mode.
+//
+// Short random segments are the easy case. Segments in a narrow band, all within a
+// milliradian of one direction, cross at tiny angles and go to the exact stage. Both modes
+// have to report the same pairs, at the same points up to the eps of the intersector.
+
+#include <cstdio>
+#include <cmath>
+
+#include "Geometry/robust_segments_intersections.h"
+#include "common/rand_stream.h"
+
+#include "geom_bench.h"
+
+using namespace cg;
+
+namespace
+{
+   typedef robust_segments_intersector<segment_2>  intersector_type;
+   typedef intersector_type::value_type            intersection;
+   typedef std::vector<intersection>               intersections;
+
+   double const eps = 1e-5;
+
+   // a point of a nearly collinear pair moves along the segments with the rounding of the
+   // pieces, so the points of the two modes only agree up to eps
+   bool same( intersections const & a, intersections const & b )
+   {
+      if (a.size() != b.size())
+         return false;
+
+      for (size_t i = 0; i != a.size(); ++i)
+      {
+         if (a[i].idA() != b[i].idA() || a[i].idB() != b[i].idB() || a[i].type() != b[i].type() ||
+             distance(a[i].p(), b[i].p()) > eps)
+            return false;
+      }
+      return true;
+   }
+
+   template <bool Parallel>
+      struct run_intersector
+   {
+      run_intersector(std::vector<segment_2> const & segs, intersections & res)
+         : segs_(segs), res_(res)
+      {}
+
+      void operator () () const
+      {
+         intersector_type isect(segs_, false, eps, EmptyFilter(), Parallel);
+         res_.assign(isect.begin(), isect.end());
+      }
+
+   private:
+      std::vector<segment_2> const & segs_;
+      intersections                & res_;
+   };
+
+   void run_set( bench_options const & opt, char const * name, std::vector<segment_2> const & segs )
+   {
+      intersections serial, parallel;
+      double const serial_ms   = best_time(opt, run_intersector<false>(segs, serial));
+      double const parallel_ms = best_time(opt, run_intersector<true >(segs, parallel));
+
+      std::sort(serial.begin(),   serial.end());
+      std::sort(parallel.begin(), parallel.end());
+
+      printf("%-10s %10.1f %10.1f %10d %10d %s\n", name, serial_ms, parallel_ms,
+         (int)serial.size(), (int)parallel.size(), same(serial, parallel) ? "" : "MISMATCH");
+   }
+}
+
+void bench_segments( bench_options const & opt )
+{
+   size_t const n = 20000 * opt.scale;
+
+   rand_stream rng(opt.seed);
+
+   std::vector<segment_2> easy(n);
+   for (size_t i = 0; i != n; ++i)
+   {
+      point_2 const a(rng.uniform() * 1000, rng.uniform() * 1000);
+      point_2 const d(rng.uniform() * 20 - 10, rng.uniform() * 20 - 10);
+      easy[i] = segment_2(a, a + d);
+   }
+
+   std::vector<segment_2> hard(n);
+   for (size_t i = 0; i != n; ++i)
+   {
+      point_2 const a(rng.uniform() * 1000, 500 + rng.uniform());
+      double  const angle = (rng.uniform() - 0.5) * 0.002;
+      hard[i] = segment_2(a, a + point_2(20 * cos(angle), 20 * sin(angle)));
+   }
+
+   printf("%d segments\n", (int)n);
+   printf("%-10s %10s %10s %10s %10s\n", "input", "serial ms", "parall ms", "serial", "parallel");
+   run_set(opt, "random",    easy);
+   run_set(opt, "collinear", hard);
+}